@@ -22,578 +22,2877 @@
 //
 
 #include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
+#include <algorithm>
+#include <functional>
+
+#include <QAtomicInteger>
+#include <QBuffer>
+#include <QDataStream>
+#include <QDateTime>
 #include <QDir>
+#include <QElapsedTimer>
 #include <QFile>
+#include <QFileDevice>
+#include <QFileInfo>
+#include <QIODevice>
+#include <QRunnable>
+#include <QSaveFile>
+#include <QSemaphore>
+#include <QSet>
 #include <QStringList>
 #include <QTextStream>
+#include <QThread>
+#include <QThreadPool>
+#include <QVector>
 
 #include "profile.h"
+#include "profilescanner.h"
 
 #define __PROFILE_SECTION_ID_DELIMITER "|"
 #define __PROFILE_DEFAULT_SECTION_ID "Default"
+#define __PROFILE_PARALLEL_CHUNK_SIZE 4194304
+#define __PROFILE_COMPILED_MAGIC 0x43505845
+#define __PROFILE_COMPILED_VERSION 3
+#define __PROFILE_COMPILED_HEADER_SIZE 28
+#define __PROFILE_COMPILED_FLAG_SECTION_IDS 0x01
+#define __PROFILE_DUMP_BUFFER_SIZE 65536
 
-Profile::Profile(bool use_section_ids)
+//
+// Blocks are keyed on the interned section name in the upper half and the
+// interned section ID (or -1 when IDs are not in use) in the lower half.
+//
+static inline quint64 __Profile_BlockKey(int section,int id)
 {
-  d_use_section_ids=use_section_ids;
+  return ((quint64)(quint32)section<<32)|(quint64)(quint32)id;
 }
 
 
-QStringList Profile::sectionNames() const
+static inline int __Profile_KeySection(quint64 key)
 {
-  return d_blocks.keys();
+  return (int)(quint32)(key>>32);
 }
 
 
-QString Profile::source() const
+static inline int __Profile_KeyId(quint64 key)
 {
-  return profile_source;
+  return (int)(quint32)key;
 }
 
 
-bool Profile::addSource(const QStringList &values)
+static inline bool __Profile_IsSpace(char c)
 {
-  QString block_name;
-  QMap<QString,QStringList> block_lines;
+  return (c==' ')||((c>='\t')&&(c<='\r'));
+}
 
-  for(int i=0;i<values.size();i++) {
-    QString line=values.at(i);
-    if((line.left(1)=="[")&&(line.right(1)=="]")) {  // Block Starts
-      if(!block_name.isEmpty()) {
-	ProcessBlock(block_name,block_lines);
-      }
-      block_name=line.mid(1,line.size()-2);
-      block_lines.clear();
-    }
-    else {
-      if((!line.isEmpty())&&(line.left(1)!=";")&&(line.left(1)!="#")) {
-	QStringList f0=line.split("=",Qt::KeepEmptyParts);
-	QString tag=f0.at(0);
-	f0.removeFirst();
-	QStringList f1=block_lines.value(tag,QStringList());
-	f1.push_back(f0.join("="));
-	block_lines[tag]=f1;
-      }
-    }
-  }
-  if(!block_name.isEmpty()) {
-    ProcessBlock(block_name,block_lines);
+
+//
+// True if the data starts with a UTF-16 or UTF-32 byte order mark
+//
+static bool __Profile_IsWideText(const char *data,qint64 len)
+{
+  if((len>=4)&&(memcmp(data,"\x00\x00\xFE\xFF",4)==0)) {
+    return true;
   }
-  
-  return true;
+  return (len>=2)&&((memcmp(data,"\xFF\xFE",2)==0)||
+		    (memcmp(data,"\xFE\xFF",2)==0));
 }
 
 
-bool Profile::loadFile(const QString &filename,QString *err_msg)
+//
+// Run 'func' for each index in [0,count) using whatever global thread pool
+// workers happen to be idle. The calling thread takes a share of the work
+// as well, so this never blocks waiting on a pool that is already busy.
+//
+class __Profile_Worker : public QRunnable
 {
-  QFile data(filename);
-  if(!data.open(QFile::ReadOnly)) {
-    if(err_msg!=NULL) {
-      *err_msg="unable to open file";
+ public:
+  __Profile_Worker(const std::function<void()> &func,QSemaphore *done)
+    : QRunnable()
+  {
+    d_func=func;
+    d_done=done;
+    setAutoDelete(true);
+  }
+  void run()
+  {
+    d_func();
+    d_done->release();
+  }
+
+ private:
+  std::function<void()> d_func;
+  QSemaphore *d_done;
+};
+
+
+static void __Profile_ParallelFor(int count,
+				  const std::function<void(int)> &func)
+{
+  QAtomicInt next(0);
+  QSemaphore done;
+  int started=0;
+
+  std::function<void()> drain=[&next,&func,count]() {
+    int n;
+    while((n=next.fetchAndAddOrdered(1))<count) {
+      func(n);
     }
-    return false;
+  };
+  for(int i=1;i<count;i++) {
+    __Profile_Worker *worker=new __Profile_Worker(drain,&done);
+    if(!QThreadPool::globalInstance()->tryStart(worker)) {
+      delete worker;
+      break;
+    }
+    started++;
   }
-  QTextStream in(&data);
-  QString line;
-  QStringList values;
-  while(in.readLineInto(&line)) {
-    values.push_back(line.trimmed());
+  drain();
+  done.acquire(started);
+}
+
+
+//
+// FNV-1a, taken a word at a time. This guards compiled profiles against
+// truncation and corruption, not tampering.
+//
+static quint64 __Profile_Checksum(const char *data,qint64 len)
+{
+  quint64 hash=14695981039346656037ull;
+  quint64 word;
+  qint64 i=0;
+
+  for(;(i+8)<=len;i+=8) {
+    memcpy(&word,data+i,8);
+    hash=(hash^word)*1099511628211ull;
   }
-  addSource(values);
-  if(err_msg!=NULL) {
-    *err_msg=
-      QString::asprintf("loaded file \"%s\"",filename.toUtf8().constData());
+  for(;i<len;i++) {
+    hash=(hash^(quint8)data[i])*1099511628211ull;
   }
 
-  return true;
+  return hash;
 }
 
 
-int Profile::loadDirectory(const QString &dirpath,const QString &glob_template,
-			   QStringList *err_msgs)
+//
+// Every change to the contents of a Profile takes a new generation number
+// from this process-wide counter, so a Key can tell whether the value slot
+// it last resolved is still current simply by comparing numbers.
+//
+static QAtomicInteger<quint64> __profile_generation;
+
+static quint64 __Profile_NextGeneration()
 {
-  QString err_msg;
-  QDir dir(dirpath);
-  int ret=0;
+  return __profile_generation.fetchAndAddRelaxed(1)+1;
+}
 
-  if(!dir.exists()) {
-    if(err_msgs!=NULL) {
-      err_msgs->push_back(QObject::tr("no such directory"));
-      return -1;
-    }
+
+static QAtomicInteger<qint64> __profile_file_cache_limit(0);
+
+
+//
+// Buffered UTF-8 output for Profile::dump(). Text is encoded straight into
+// a fixed buffer that is handed to the device or stream whenever it fills,
+// so no intermediate QString or QByteArray of the whole dump is built.
+// Unpaired surrogates are written as '?', as QString::toUtf8() does.
+//
+class __Profile_DumpWriter
+{
+ public:
+  __Profile_DumpWriter(QIODevice *dev,FILE *f)
+  {
+    d_dev=dev;
+    d_file=f;
+    d_used=0;
+    d_ok=true;
   }
-  if(!dir.isReadable()) {
-    if(err_msgs!=NULL) {
-      err_msgs->push_back(QObject::tr("directory is not readable"));
-      return -1;
+  void write(const char *data,int len)
+  {
+    while(len>0) {
+      if(d_used==__PROFILE_DUMP_BUFFER_SIZE) {
+	flush();
+      }
+      int n=qMin(len,__PROFILE_DUMP_BUFFER_SIZE-d_used);
+      memcpy(d_buffer+d_used,data,n);
+      d_used+=n;
+      data+=n;
+      len-=n;
     }
   }
-  QStringList name_filters;
-  name_filters.push_back(glob_template);
-  QStringList filenames=dir.entryList(name_filters,QDir::Files,QDir::Name);
-  for(int i=0;i<filenames.size();i++) {
-    if(loadFile(dir.path()+"/"+filenames.at(i),&err_msg)) {
-      if(err_msgs!=NULL) {
-	err_msgs->push_back(QString::asprintf("loaded file \"%s/%s\"",
-				     dir.path().toUtf8().constData(),
-				     filenames.at(i).toUtf8().constData()));
+  void write(const QString &str)
+  {
+    const ushort *uc=str.utf16();
+    int len=str.size();
+
+    for(int i=0;i<len;i++) {
+      if((__PROFILE_DUMP_BUFFER_SIZE-d_used)<4) {
+	flush();
       }
-      ret++;
+      char *dst=d_buffer+d_used;
+      uint c=uc[i];
+      if(c<0x80) {
+	*dst++=(char)c;
+      }
+      else {
+	if(c<0x800) {
+	  *dst++=(char)(0xC0|(c>>6));
+	  *dst++=(char)(0x80|(c&0x3F));
+	}
+	else {
+	  if((c>=0xD800)&&(c<=0xDFFF)) {
+	    if((c<0xDC00)&&((i+1)<len)&&(uc[i+1]>=0xDC00)&&
+	       (uc[i+1]<=0xDFFF)) {
+	      c=0x10000+((c-0xD800)<<10)+(uc[++i]-0xDC00);
+	      *dst++=(char)(0xF0|(c>>18));
+	      *dst++=(char)(0x80|((c>>12)&0x3F));
+	      *dst++=(char)(0x80|((c>>6)&0x3F));
+	      *dst++=(char)(0x80|(c&0x3F));
+	    }
+	    else {
+	      *dst++='?';
+	    }
+	  }
+	  else {
+	    *dst++=(char)(0xE0|(c>>12));
+	    *dst++=(char)(0x80|((c>>6)&0x3F));
+	    *dst++=(char)(0x80|(c&0x3F));
+	  }
+	}
+      }
+      d_used=dst-d_buffer;
     }
-    else {
-      if(err_msgs!=NULL) {
-	err_msgs->
-	  push_back(QString::asprintf("failed to load file \"%s\": %s",
-				      filenames.at(i).toUtf8().constData(),
-				      err_msg.toUtf8().constData()));
+  }
+  bool flush()
+  {
+    if(d_ok&&(d_used>0)) {
+      if(d_dev!=NULL) {
+	d_ok=d_dev->write(d_buffer,d_used)==d_used;
+      }
+      else {
+	d_ok=fwrite(d_buffer,1,d_used,d_file)==(size_t)d_used;
       }
     }
+    d_used=0;
+    return d_ok;
   }
 
-  return ret;
-}
+ private:
+  QIODevice *d_dev;
+  FILE *d_file;
+  char d_buffer[__PROFILE_DUMP_BUFFER_SIZE];
+  int d_used;
+  bool d_ok;
+};
 
 
-int Profile::load(const QString &glob_path,QStringList *err_msgs)
+Profile::Key::Key()
 {
-  QString err_msg;
-  QFileInfo finfo(glob_path);
-  if(finfo.isFile()) {
-    int ret=loadFile(glob_path,&err_msg);
-    if(err_msgs!=NULL) {
-      err_msgs->push_back(err_msg);
-    }
-    return ret;
-  }
+  d_use_section_id=false;
+  d_profile=NULL;
+  d_generation=0;
+  d_values=NULL;
+  d_layer=0;
+}
 
-  QStringList f0=glob_path.split("/",Qt::KeepEmptyParts);
-  QString glob_template=f0.last();
-  f0.removeLast();
-  QString dir_path=f0.join("/");
-  
-  return loadDirectory(dir_path,glob_template,err_msgs);
+
+Profile::Key::Key(const QString &section,const QString &tag)
+{
+  d_section=section;
+  d_tag=tag;
+  d_use_section_id=false;
+  d_profile=NULL;
+  d_generation=0;
+  d_values=NULL;
+  d_layer=0;
 }
 
 
-QStringList Profile::sections() const
+Profile::Key::Key(const QString &section,const QString &section_id,
+		  const QString &tag)
 {
-  QStringList ret;
+  d_section=section;
+  d_section_id=section_id;
+  d_tag=tag;
+  d_use_section_id=true;
+  d_profile=NULL;
+  d_generation=0;
+  d_values=NULL;
+  d_layer=0;
+}
 
-  for(QMap<QString,QMap<QString,QStringList> >::const_iterator it=
-	d_blocks.begin();it!=d_blocks.end();it++) {
-    QStringList f0=it.key().split(__PROFILE_SECTION_ID_DELIMITER);
-    if(!ret.contains(f0.first())) {
-      ret.push_front(f0.first());
-    }
-  }
 
-  return ret;
+QString Profile::Key::section() const
+{
+  return d_section;
 }
 
 
-QStringList Profile::sectionIds(const QString &section) const
+QString Profile::Key::sectionId() const
 {
-  QStringList ret;
+  return d_section_id;
+}
 
-  for(QMap<QString,QMap<QString,QStringList> >::const_iterator it=
-	d_blocks.begin();it!=d_blocks.end();it++) {
-    QStringList f0=it.key().split(__PROFILE_SECTION_ID_DELIMITER);
-    if((f0.size()==2)&&(f0.first()==section)) {
-      ret.push_back(f0.last());
-    }
-  }
 
-  return ret;
+QString Profile::Key::tag() const
+{
+  return d_tag;
 }
 
 
-QString Profile::stringValue(const QString &section,const QString &tag,
-			     const QString &default_str,bool *found)
+Profile::Profile(bool use_section_ids)
 {
-  QStringList values=stringValues(section,tag);
-  if(found!=NULL) {
-    *found=values.size()>0;
-  }
-  if(values.size()==0) {
-    return default_str;
-  }
-  return values.first();
+  d_generation=__Profile_NextGeneration();
+  d_unkeyed_source=false;
+  d_use_section_ids=use_section_ids;
+  d_concurrent_load=false;
+  d_lazy_load=false;
+  d_stats=NULL;
 }
 
 
-QStringList Profile::stringValues(const QString &section,const QString &tag)
+Profile::Profile(const Profile &other)
 {
-  QMap<QString,QStringList> block=d_blocks.value(section);
-  if(block.size()==0) {
-    return QStringList();
-  }
-  return block.value(tag);
+  d_stats=NULL;
+  CopyFrom(other);
 }
 
 
-QStringList Profile::stringValues(const QString &section,
-				  const QString &section_id,
-				  const QString &tag) const
+Profile::~Profile()
 {
-  QMap<QString,QStringList> block=
-    d_blocks.value(section+__PROFILE_SECTION_ID_DELIMITER+section_id);
-  if(block.size()==0) {
-    return QStringList();
+  if(d_stats!=NULL) {
+    delete d_stats;
   }
-  
-  return block.value(tag);
 }
 
 
-int Profile::intValue(const QString &section,const QString &tag,
-		      int default_value,bool *found)
+Profile &Profile::operator=(const Profile &other)
 {
-  QList<int> values=intValues(section,tag);
-  if(found!=NULL) {
-    *found=values.size()>0;
-  }
-  if(values.size()==0) {
-    return default_value;
+  if(this!=&other) {
+    CopyFrom(other);
   }
-  return values.first();
+  return *this;
 }
 
 
-QList<int> Profile::intValues(const QString &section,const QString &tag)
+bool Profile::concurrentLoad() const
 {
-  QMap<QString,QStringList> block=d_blocks.value(section);
-  if(block.size()==0) {
-    return QList<int>();
-  }
-  QList<int> ret;
-  QStringList values=block.value(tag);
-  for(int i=0;i<values.size();i++) {
-    ret.push_back(values.at(i).toInt());
-  }
-  return ret;
+  return d_concurrent_load;
 }
 
 
-QList<int> Profile::intValues(const QString &section,const QString &section_id,
-			      const QString &tag)
+void Profile::setConcurrentLoad(bool state)
 {
-  QList<int> ret;
-  
-  QMap<QString,QStringList> block=
-    d_blocks.value(section+__PROFILE_SECTION_ID_DELIMITER+section_id);
-  if(block.size()==0) {
-    return ret;
-  }
-  QStringList values=block.value(tag);
-  for(int i=0;i<values.size();i++) {
-    ret.push_back(values.at(i).toInt());
-  }
-  
-  return ret;
+  d_concurrent_load=state;
 }
 
 
-int Profile::hexValue(const QString &section,const QString &tag,
-		       int default_value,bool *found)
+bool Profile::lazyLoad() const
 {
-  QList<int> values=hexValues(section,tag);
-  if(found!=NULL) {
-    *found=values.size()>0;
-  }
-  if(values.size()==0) {
-    return default_value;
-  }
-  return values.first();
+  return d_lazy_load;
 }
 
 
-QList<int> Profile::hexValues(const QString &section,const QString &tag)
+void Profile::setLazyLoad(bool state)
 {
-  QMap<QString,QStringList> block=d_blocks.value(section);
-  if(block.size()==0) {
-    return QList<int>();
-  }
-  QList<int> ret;
-  QStringList values=block.value(tag);
-  for(int i=0;i<values.size();i++) {
-    ret.push_back(values.at(i).toInt(NULL,16));
-  }
-  return ret;
+  d_lazy_load=state;
 }
 
 
-QList<int> Profile::hexValues(const QString &section,const QString &section_id,
-			      const QString &tag)
+//
+// Sections whose file changed on disk between being scanned and being
+// read are taken from what the file holds now, and noted here.
+//
+QStringList Profile::lazyLoadErrors() const
 {
-  QList<int> ret;
-  
-  QMap<QString,QStringList> block=
-    d_blocks.value(section+__PROFILE_SECTION_ID_DELIMITER+section_id);
-  if(block.size()==0) {
-    return ret;
-  }
-  QStringList values=block.value(tag);
-  for(int i=0;i<values.size();i++) {
-    ret.push_back(values.at(i).toInt(NULL,16));
-  }
-  
-  return ret;
+  QMutexLocker locker(&d_lazy_mutex);
+
+  return d_lazy_errors;
 }
 
 
-double Profile::doubleValue(const QString &section,const QString &tag,
-			    double default_value,bool *found)
+bool Profile::statsEnabled() const
 {
-  QList<double> values=doubleValues(section,tag);
-  if(found!=NULL) {
-    *found=values.size()>0;
-  }
-  if(values.size()==0) {
-    return default_value;
-  }
-  return values.first();
+  return d_stats!=NULL;
 }
 
 
-QList<double> Profile::doubleValues(const QString &section,const QString &tag)
+void Profile::setStatsEnabled(bool state)
 {
-  QMap<QString,QStringList> block=d_blocks.value(section);
-  if(block.size()==0) {
-    return QList<double>();
+  if(state&&(d_stats==NULL)) {
+    d_stats=new StatsCounters();
   }
-  QList<double> ret;
-  QStringList values=block.value(tag);
-  for(int i=0;i<values.size();i++) {
-    ret.push_back(values.at(i).toDouble());
+  if((!state)&&(d_stats!=NULL)) {
+    delete d_stats;
+    d_stats=NULL;
   }
-  return ret;
 }
 
 
-QList<double> Profile::doubleValues(const QString &section,
-				    const QString &section_id,
-				    const QString &tag)
+//
+// Contents and heap usage are worked out when the snapshot is taken.
+// Sections still waiting to be materialized by a lazy load are reported
+// as pending and are not parsed just to be counted. Only this profile's
+// own layer is counted; any base layers are shared and so are left out.
+//
+ProfileStats Profile::stats() const
 {
-  QList<double> ret;
-  
-  QMap<QString,QStringList> block=
-    d_blocks.value(section+__PROFILE_SECTION_ID_DELIMITER+section_id);
-  if(block.size()==0) {
+  ProfileStats ret;
+
+  if(d_stats==NULL) {
     return ret;
   }
-  QStringList values=block.value(tag);
-  for(int i=0;i<values.size();i++) {
-    ret.push_back(values.at(i).toDouble());
+  ret.d_enabled=true;
+  ret.d_files=d_stats->files;
+  for(int i=0;i<ProfileStats::LastType;i++) {
+    ret.d_hits[i]=d_stats->hits[i].loadAcquire();
+    ret.d_misses[i]=d_stats->misses[i].loadAcquire();
+  }
+  ret.d_layer_count=layerCount();
+  for(int i=0;i<PROFILESTATS_MAX_LAYERS;i++) {
+    ret.d_layer_hits[i]=d_stats->layer_hits[i].loadAcquire();
   }
-  
-  return ret;
-}
-
 
-bool Profile::boolValue(const QString &section,const QString &tag,
-			 bool default_value,bool *found)
-{
-  QList<bool> values=boolValues(section,tag);
-  if(found!=NULL) {
-    *found=values.size()>0;
+  QMutexLocker locker(&d_lazy_mutex);
+  QSet<const LazyBuffer *> buffers;
+  ret.d_section_count=d_blocks.size();
+  ret.d_heap_bytes=sizeof(Profile)+d_symbols.heapBytes()+
+    PROFILESTATS_HASH_NODE_BYTES*(d_blocks.size()+d_section_index.size()+
+				  d_section_order.size()+d_lazy_blocks.size());
+  for(QHash<quint64,Block>::const_iterator it=d_blocks.constBegin();
+      it!=d_blocks.constEnd();it++) {
+    QHash<quint64,LazyBlock>::const_iterator lazy=
+      d_lazy_blocks.constFind(it.key());
+    if((lazy!=d_lazy_blocks.constEnd())&&
+       (lazy.value().materialized.loadAcquire()==0)) {
+      ret.d_pending_section_count++;
+      for(int i=0;i<lazy.value().ranges.size();i++) {
+	buffers.insert(lazy.value().ranges.at(i).buffer.data());
+      }
+    }
+    const Block &block=it.value();
+    ret.d_tag_count+=block.size();
+    ret.d_heap_bytes+=PROFILESTATS_HASH_NODE_BYTES*block.size();
+    for(Block::const_iterator it1=block.constBegin();it1!=block.constEnd();
+	it1++) {
+      ret.d_value_count+=it1.value().size();
+      ret.d_heap_bytes+=it1.value().heapBytes();
+    }
   }
-  if(values.size()==0) {
-    return default_value;
+  for(QSet<const LazyBuffer *>::const_iterator it=buffers.constBegin();
+      it!=buffers.constEnd();it++) {
+    ret.d_heap_bytes+=(*it)->heapBytes();
   }
-  return values.first();
+
+  return ret;
 }
 
 
-QList<bool> Profile::boolValues(const QString &section,const QString &tag)
+void Profile::resetStats()
 {
-  QMap<QString,QStringList> block=d_blocks.value(section);
-  if(block.size()==0) {
-    return QList<bool>();
+  if(d_stats!=NULL) {
+    delete d_stats;
+    d_stats=new StatsCounters();
   }
-  QList<bool> ret;
-  QStringList values=block.value(tag);
-  for(int i=0;i<values.size();i++) {
-    ret.push_back((values.at(i).toLower()=="yes")||
-		  (values.at(i).toLower()=="true")||
-		  (values.at(i).toLower()=="on")||
-		  (values.at(i).toLower()=="1"));
-  }
-  return ret;
 }
 
 
-QList<bool> Profile::boolValues(const QString &section,
-				const QString &section_id,
-				const QString &tag)
+//
+// A profile can sit on top of a stack of base layers. Lookups fall through
+// from each layer to the one beneath it until the tag is found, with a
+// tag in an upper layer replacing all of the values of the same tag below
+// it. Base layers are held by shared pointer, so any number of profiles
+// can share one without copying it. They must not be changed while they
+// are in use as a base.
+//
+QSharedPointer<const Profile> Profile::baseLayer() const
 {
-  QList<bool> ret;
-  
-  QMap<QString,QStringList> block=
-    d_blocks.value(section+__PROFILE_SECTION_ID_DELIMITER+section_id);
-  if(block.size()==0) {
-    return ret;
-  }
-  QStringList values=block.value(tag);
-  for(int i=0;i<values.size();i++) {
-    ret.push_back((values.at(i).toLower()=="yes")||
-		  (values.at(i).toLower()=="true")||
-		  (values.at(i).toLower()=="on")||
-		  (values.at(i).toLower()=="1"));
-  }
-  
-  return ret;
+  return d_base;
 }
 
 
-QTime Profile::timeValue(const QString &section,const QString &tag,
-			   const QTime &default_value,bool *found)
+bool Profile::setBaseLayer(const QSharedPointer<const Profile> &base)
 {
-  QList<QTime> values=timeValues(section,tag);
-  if(found!=NULL) {
-    *found=values.size()>0;
-  }
-  if(values.size()==0) {
-    return default_value;
+  for(const Profile *layer=base.data();layer!=NULL;
+      layer=layer->d_base.data()) {
+    if((layer==this)||(layer->d_use_section_ids!=d_use_section_ids)) {
+      return false;
+    }
   }
-  return values.first();
+  d_base=base;
+  d_generation=__Profile_NextGeneration();
+
+  return true;
 }
 
 
-QList<QTime> Profile::timeValues(const QString &section,const QString &tag)
+int Profile::layerCount() const
 {
-  QMap<QString,QStringList> block=d_blocks.value(section);
-  if(block.size()==0) {
-    return QList<QTime>();
-  }
-  QList<QTime> ret;
-  QStringList values=block.value(tag);
-  for(int i=0;i<values.size();i++) {
-    QStringList fields=values.at(i).split(":");
-    if(fields.size()==2) {
-      ret.push_back(QTime(fields.at(0).toInt(),fields.at(1).toInt(),0));
-    }
-    else {
-      if(fields.size()==3) {
-	ret.push_back(QTime(fields.at(0).toInt(),fields.at(1).toInt(),
-			    fields.at(2).toInt()));
-      }
-      else {
-	ret.push_back(QTime());
-      }
-    }
+  int ret=0;
+
+  for(const Profile *layer=this;layer!=NULL;layer=layer->d_base.data()) {
+    ret++;
   }
+
   return ret;
 }
 
 
-QList<QTime> Profile::timeValues(const QString &section,
-				 const QString &section_id,
-				 const QString &tag)
+QStringList Profile::sectionNames() const
 {
-  QList<QTime> ret;
+  QStringList ret;
 
-  QMap<QString,QStringList> block=
-    d_blocks.value(section+__PROFILE_SECTION_ID_DELIMITER+section_id);
-  if(block.size()==0) {
-    return ret;
+  if(!d_base.isNull()) {
+    return LayeredBlockNames().keys();
   }
-  QStringList values=block.value(tag);
-  for(int i=0;i<values.size();i++) {
-    QStringList fields=values.at(i).split(":");
-    if(fields.size()==2) {
-      ret.push_back(QTime(fields.at(0).toInt(),fields.at(1).toInt(),0));
-    }
-    else {
-      if(fields.size()==3) {
-	ret.push_back(QTime(fields.at(0).toInt(),fields.at(1).toInt(),
-			    fields.at(2).toInt()));
-      }
-      else {
-	ret.push_back(QTime());
-      }
-    }
+  QList<quint64> keys=SortedBlockKeys();
+  for(int i=0;i<keys.size();i++) {
+    ret.push_back(BlockName(keys.at(i)));
   }
-  
+
   return ret;
 }
 
 
-QHostAddress Profile::addressValue(const QString &section,const QString &tag,
-				  const QHostAddress &default_value,bool *found)
+QString Profile::source() const
 {
-  return QHostAddress(stringValue(section,tag,default_value.toString(),found));
+  return profile_source;
 }
 
 
-QHostAddress Profile::addressValue(const QString &section,const QString &tag,
-				     const QString &default_value,bool *found)
+bool Profile::addSource(const QStringList &values)
 {
-  return addressValue(section,tag,QHostAddress(default_value),found);
+  QStringList lines=values;
+
+  AddSourceLines(&lines,false);
+
+  return true;
 }
 
 
-QList<QHostAddress> Profile::addressValues(const QString &section,
-					   const QString &tag)
+bool Profile::addSource(QStringList &&values)
 {
-  QMap<QString,QStringList> block=d_blocks.value(section);
-  if(block.size()==0) {
-    return QList<QHostAddress>();
+  QStringList lines;
+
+  lines.swap(values);
+  AddSourceLines(&lines,true);
+
+  return true;
+}
+
+
+bool Profile::loadData(const char *data,qint64 len,QString *err_msg)
+{
+  BlockList blocks;
+  QElapsedTimer timer;
+
+  timer.start();
+  ParseBuffer(data,len,&blocks);
+  ProcessBlocks(blocks);
+  d_unkeyed_source=true;
+  AddFileStats(QString(),len,timer.nsecsElapsed());
+  if(err_msg!=NULL) {
+    *err_msg=QString::asprintf("loaded %lld bytes",(long long)len);
+  }
+
+  return true;
+}
+
+
+bool Profile::loadData(const QByteArray &data,QString *err_msg)
+{
+  return loadData(data.constData(),data.size(),err_msg);
+}
+
+
+//
+// Buffers and regular files are parsed where they lie, the same way
+// loadFile() does it; anything else is read into memory first. Either
+// way, the device is left positioned at its end.
+//
+bool Profile::loadDevice(QIODevice *dev,QString *err_msg)
+{
+  if((dev==NULL)||(!dev->isReadable())) {
+    if(err_msg!=NULL) {
+      *err_msg="device is not readable";
+    }
+    return false;
+  }
+
+  QBuffer *buffer=qobject_cast<QBuffer *>(dev);
+  if(buffer!=NULL) {
+    const QByteArray &bytes=buffer->data();
+    qint64 pos=qMin(buffer->pos(),(qint64)bytes.size());
+    loadData(bytes.constData()+pos,bytes.size()-pos,NULL);
+    buffer->seek(bytes.size());
+    if(err_msg!=NULL) {
+      *err_msg=QString::asprintf("loaded %lld bytes from buffer",
+				 (long long)(bytes.size()-pos));
+    }
+    return true;
+  }
+
+  QFileDevice *file=qobject_cast<QFileDevice *>(dev);
+  if((file!=NULL)&&(!file->isSequential())) {
+    qint64 pos=file->pos();
+    qint64 len=file->size()-pos;
+    uchar *mem=NULL;
+    if(len>0) {
+      mem=file->map(pos,len);
+    }
+    if(mem!=NULL) {
+      loadData((const char *)mem,len,NULL);
+      file->unmap(mem);
+      file->seek(pos+len);
+      if(err_msg!=NULL) {
+	*err_msg=QString::asprintf("loaded %lld bytes from file \"%s\"",
+				   (long long)len,
+				   file->fileName().toUtf8().constData());
+      }
+      return true;
+    }
+  }
+
+  QByteArray bytes=dev->readAll();
+  loadData(bytes.constData(),bytes.size(),NULL);
+  if(err_msg!=NULL) {
+    if(file!=NULL) {
+      *err_msg=QString::asprintf("loaded %lld bytes from file \"%s\"",
+				 (long long)bytes.size(),
+				 file->fileName().toUtf8().constData());
+    }
+    else {
+      *err_msg=QString::asprintf("loaded %lld bytes from device",
+				 (long long)bytes.size());
+    }
+  }
+
+  return true;
+}
+
+
+//
+// Copies share any lazily loaded buffers and base layers with the
+// original, but each materializes its own blocks. Statistics are copied
+// as they stand.
+//
+void Profile::CopyFrom(const Profile &other)
+{
+  QMutexLocker locker(&other.d_lazy_mutex);
+
+  profile_source=other.profile_source;
+  d_blocks=other.d_blocks;
+  d_section_index=other.d_section_index;
+  d_section_order=other.d_section_order;
+  d_symbols=other.d_symbols;
+  d_sources=other.d_sources;
+  d_base=other.d_base;
+  d_unkeyed_source=other.d_unkeyed_source;
+  d_use_section_ids=other.d_use_section_ids;
+  d_concurrent_load=other.d_concurrent_load;
+  d_lazy_load=other.d_lazy_load;
+  d_lazy_blocks=other.d_lazy_blocks;
+  d_lazy_errors=other.d_lazy_errors;
+
+  //
+  // Materialize() fills blocks in place through a const path, so the
+  // copy must not go on sharing them with the original
+  //
+  d_blocks.detach();
+  d_lazy_blocks.detach();
+  if(d_stats!=NULL) {
+    delete d_stats;
+    d_stats=NULL;
+  }
+  if(other.d_stats!=NULL) {
+    d_stats=new StatsCounters(*other.d_stats);
+  }
+  d_generation=__Profile_NextGeneration();
+}
+
+
+//
+// When 'consume' is set, each line is released as soon as it has been
+// added, so that the caller's strings and the compact values are never
+// both held in full.
+//
+void Profile::AddSourceLines(QStringList *lines,bool consume)
+{
+  QString block_name;
+  QMap<QString,ProfileValues> block_lines;
+
+  d_unkeyed_source=true;
+
+  for(int i=0;i<lines->size();i++) {
+    QString line=lines->at(i);
+    if(consume) {
+      (*lines)[i]=QString();
+    }
+    if(line.startsWith('[')&&line.endsWith(']')) {  // Block Starts
+      if(!block_name.isEmpty()) {
+	ProcessBlock(block_name,block_lines);
+      }
+      block_name=line.mid(1,line.size()-2);
+      block_lines.clear();
+    }
+    else {
+      if((!line.isEmpty())&&(line.at(0)!=';')&&(line.at(0)!='#')) {
+	int sep=line.indexOf('=');
+	if(sep<0) {
+	  block_lines[line].append(QString());
+	}
+	else {
+	  block_lines[line.left(sep)].append(QStringView(line).mid(sep+1));
+	}
+      }
+    }
+  }
+  if(!block_name.isEmpty()) {
+    ProcessBlock(block_name,block_lines);
+  }
+}
+
+
+bool Profile::loadFile(const QString &filename,QString *err_msg)
+{
+  BlockList blocks;
+  SourceFile src;
+  bool cached=false;
+  QElapsedTimer timer;
+
+  timer.start();
+  if(d_lazy_load) {
+    if(!LazyReadFile(filename,err_msg,&src)) {
+      return false;
+    }
+  }
+  else {
+    if(!ReadFile(filename,&blocks,err_msg,&src,&cached)) {
+      return false;
+    }
+    ProcessBlocks(blocks);
+  }
+  AddFileStats(filename,src.size,timer.nsecsElapsed(),cached);
+  SetSource(filename,QString(),QList<SourceFile>()<<src);
+  if(err_msg!=NULL) {
+    *err_msg=
+      QString::asprintf("loaded file \"%s\"",filename.toUtf8().constData());
+  }
+
+  return true;
+}
+
+
+int Profile::loadDirectory(const QString &dirpath,const QString &glob_template,
+			   QStringList *err_msgs)
+{
+  QString path;
+  QStringList filenames;
+  int ret=0;
+
+  if(!ListDirectory(dirpath,glob_template,&path,&filenames,err_msgs)) {
+    return -1;
+  }
+
+  //
+  // In concurrent mode, every file is read and tokenized up front. Either
+  // way, the results are merged strictly in directory order.
+  //
+  QVector<BlockList> blocks(filenames.size());
+  QVector<QString> err_msg(filenames.size());
+  QVector<bool> loaded(filenames.size());
+  QVector<SourceFile> srcs(filenames.size());
+  QVector<qint64> nsecs(filenames.size());
+  QVector<bool> cached(filenames.size());
+  QElapsedTimer timer;
+  if(d_concurrent_load&&(!d_lazy_load)) {
+    BlockList *block_results=blocks.data();
+    QString *err_results=err_msg.data();
+    bool *load_results=loaded.data();
+    SourceFile *src_results=srcs.data();
+    qint64 *nsec_results=nsecs.data();
+    bool *cache_results=cached.data();
+    __Profile_ParallelFor(filenames.size(),[&](int n) {
+	QElapsedTimer read_timer;
+	read_timer.start();
+	load_results[n]=ReadFile(path+"/"+filenames.at(n),
+				 block_results+n,err_results+n,
+				 src_results+n,cache_results+n);
+	nsec_results[n]=read_timer.nsecsElapsed();
+      });
+  }
+  for(int i=0;i<filenames.size();i++) {
+    timer.start();
+    if(d_lazy_load) {
+      loaded[i]=LazyReadFile(path+"/"+filenames.at(i),&err_msg[i],&srcs[i]);
+    }
+    else {
+      if(!d_concurrent_load) {
+	loaded[i]=ReadFile(path+"/"+filenames.at(i),&blocks[i],
+			   &err_msg[i],&srcs[i],&cached[i]);
+      }
+    }
+    if(loaded.at(i)) {
+      ProcessBlocks(blocks.at(i));
+      blocks[i].clear();
+      AddFileStats(path+"/"+filenames.at(i),srcs.at(i).size,
+		   nsecs.at(i)+timer.nsecsElapsed(),cached.at(i));
+      ret++;
+    }
+    if(err_msgs!=NULL) {
+      err_msgs->
+	push_back(LoadMessage(path,filenames.at(i),loaded.at(i),err_msg.at(i)));
+    }
+  }
+  SetSource(path,glob_template,srcs.toList());
+
+  return ret;
+}
+
+
+//
+// The checks and listing shared by everything that loads a directory,
+// ProfileWatcher included, with the files in the order they are merged
+//
+bool Profile::ListDirectory(const QString &dirpath,
+			    const QString &glob_template,QString *path,
+			    QStringList *filenames,QStringList *err_msgs)
+{
+  QDir dir(dirpath);
+
+  if(!dir.exists()) {
+    if(err_msgs!=NULL) {
+      err_msgs->push_back(QObject::tr("no such directory"));
+    }
+    return false;
+  }
+  if(!dir.isReadable()) {
+    if(err_msgs!=NULL) {
+      err_msgs->push_back(QObject::tr("directory is not readable"));
+    }
+    return false;
+  }
+  QStringList name_filters;
+  name_filters.push_back(glob_template);
+  *filenames=dir.entryList(name_filters,QDir::Files,QDir::Name);
+  *path=dir.path();
+
+  return true;
+}
+
+
+QString Profile::LoadMessage(const QString &path,const QString &filename,
+			     bool loaded,const QString &err_msg)
+{
+  if(loaded) {
+    return QString::asprintf("loaded file \"%s/%s\"",
+			     path.toUtf8().constData(),
+			     filename.toUtf8().constData());
+  }
+  return QString::asprintf("failed to load file \"%s\": %s",
+			   filename.toUtf8().constData(),
+			   err_msg.toUtf8().constData());
+}
+
+
+int Profile::load(const QString &glob_path,QStringList *err_msgs)
+{
+  QString err_msg;
+  QFileInfo finfo(glob_path);
+  if(finfo.isFile()) {
+    int ret=loadFile(glob_path,&err_msg);
+    if(err_msgs!=NULL) {
+      err_msgs->push_back(err_msg);
+    }
+    return ret;
+  }
+
+  QStringList f0=glob_path.split("/",Qt::KeepEmptyParts);
+  QString glob_template=f0.last();
+  f0.removeLast();
+  QString dir_path=f0.join("/");
+  
+  return loadDirectory(dir_path,glob_template,err_msgs);
+}
+
+
+//
+// The limit is checked on every load, so it is kept outside of the cache
+// mutex. It is charged against the heap used by the parsed blocks, not
+// the size of the files they came from.
+//
+qint64 Profile::fileCacheLimit()
+{
+  return __profile_file_cache_limit.loadAcquire();
+}
+
+
+void Profile::setFileCacheLimit(qint64 bytes)
+{
+  QMutexLocker locker(FileCacheMutex());
+  FileCacheData *cache=FileCache();
+
+  __profile_file_cache_limit.storeRelease(qMax((qint64)0,bytes));
+  if(bytes<=0) {
+    cache->files.clear();
+    cache->bytes=0;
+  }
+  TrimFileCache(cache);
+}
+
+
+void Profile::clearFileCache()
+{
+  QMutexLocker locker(FileCacheMutex());
+  FileCacheData *cache=FileCache();
+
+  cache->files.clear();
+  cache->bytes=0;
+}
+
+
+bool Profile::saveCompiled(const QString &filename,QString *err_msg) const
+{
+  if(!d_base.isNull()) {
+    Profile *flat=Flattened();
+    bool ret=flat->saveCompiled(filename,err_msg);
+    delete flat;
+    return ret;
+  }
+  if(d_unkeyed_source) {
+    if(err_msg!=NULL) {
+      *err_msg="profile contains data not loaded from files";
+    }
+    return false;
+  }
+  MaterializeAll();
+
+  //
+  // Payload
+  //
+  QByteArray payload;
+  QDataStream out(&payload,QIODevice::WriteOnly);
+  out.setVersion(QDataStream::Qt_5_0);
+  out.setByteOrder(QDataStream::LittleEndian);
+  out<<(quint32)d_sources.size();
+  for(int i=0;i<d_sources.size();i++) {
+    const Source &source=d_sources.at(i);
+    out<<source.path<<source.glob_template<<(quint32)source.files.size();
+    for(int j=0;j<source.files.size();j++) {
+      out<<source.files.at(j).path<<source.files.at(j).size<<
+	source.files.at(j).mtime;
+    }
+  }
+  out<<(quint32)d_symbols.size();
+  for(int i=0;i<d_symbols.size();i++) {
+    out<<d_symbols.name(i);
+  }
+  QList<quint64> keys=SortedBlockKeys();
+  out<<(quint32)keys.size();
+  for(int i=0;i<keys.size();i++) {
+    const Block &block=d_blocks.constFind(keys.at(i)).value();
+    QList<int> tags=block.keys();
+    std::sort(tags.begin(),tags.end());
+    out<<keys.at(i)<<(quint32)tags.size();
+    for(int j=0;j<tags.size();j++) {
+      const ProfileValues &values=block.constFind(tags.at(j)).value();
+      out<<(qint32)tags.at(j)<<(quint32)values.size();
+      for(int k=0;k<values.size();k++) {
+	int len=0;
+	const char *data=values.utf8(k,&len);
+	out.writeBytes(data,len);
+      }
+    }
+  }
+
+  //
+  // Header
+  //
+  QByteArray header;
+  QDataStream hdr(&header,QIODevice::WriteOnly);
+  hdr.setByteOrder(QDataStream::LittleEndian);
+  hdr<<(quint32)__PROFILE_COMPILED_MAGIC<<(quint32)__PROFILE_COMPILED_VERSION;
+  hdr<<(quint32)(d_use_section_ids?__PROFILE_COMPILED_FLAG_SECTION_IDS:0);
+  hdr<<(quint64)payload.size()<<
+    __Profile_Checksum(payload.constData(),payload.size());
+
+  //
+  // Replace the file atomically, as other processes may have it mapped
+  //
+  QSaveFile file(filename);
+  if(!file.open(QIODevice::WriteOnly)) {
+    if(err_msg!=NULL) {
+      *err_msg="unable to open file";
+    }
+    return false;
+  }
+  if((file.write(header)!=header.size())||
+     (file.write(payload)!=payload.size())||(!file.commit())) {
+    if(err_msg!=NULL) {
+      *err_msg="unable to write file";
+    }
+    return false;
+  }
+
+  return true;
+}
+
+
+//
+// A compiled profile is a binary cache, not an image to be used in place.
+// The snapshot is mapped only to avoid an extra copy while it is checked
+// and decoded; every value is copied out of it into the usual blocks,
+// which own their storage, and the mapping is dropped before returning.
+// What is saved is the text parsing, not the building of the blocks.
+//
+bool Profile::loadCompiled(const QString &filename,QString *err_msg)
+{
+  QFile file(filename);
+  if(!file.open(QFile::ReadOnly)) {
+    if(err_msg!=NULL) {
+      *err_msg="unable to open file";
+    }
+    return false;
+  }
+  if(file.size()>0x7FFFFFFF) {
+    if(err_msg!=NULL) {
+      *err_msg="compiled profile is too large";
+    }
+    return false;
+  }
+
+  QElapsedTimer timer;
+  timer.start();
+  uchar *mem=NULL;
+  if(file.size()>0) {
+    mem=file.map(0,file.size());
+  }
+  bool ret=false;
+  if(mem!=NULL) {
+    ret=ReadCompiled(QByteArray::fromRawData((const char *)mem,file.size()),
+		     err_msg);
+    file.unmap(mem);
+  }
+  else {
+    ret=ReadCompiled(file.readAll(),err_msg);
+  }
+  if(ret) {
+    AddFileStats(filename,file.size(),timer.nsecsElapsed());
+  }
+  if(ret&&(err_msg!=NULL)) {
+    *err_msg=QString::asprintf("loaded compiled profile \"%s\"",
+			       filename.toUtf8().constData());
+  }
+
+  return ret;
+}
+
+
+QStringList Profile::sections() const
+{
+  QStringList ret;
+
+  if(!d_base.isNull()) {
+    //
+    // The first block of each section carries its lowest ID, which is what
+    // IndexBlock() orders sections by
+    //
+    QMap<QString,QPair<QString,QString> > names=LayeredBlockNames();
+    QMap<QString,bool> seen;
+    QMultiMap<QString,QString> order;
+    for(QMap<QString,QPair<QString,QString> >::const_iterator it=
+	  names.constBegin();it!=names.constEnd();it++) {
+      if(!seen.contains(it.value().first)) {
+	order.insert(it.key(),it.value().first);
+	seen[it.value().first]=true;
+      }
+    }
+    for(QMultiMap<QString,QString>::const_iterator it=order.constBegin();
+	it!=order.constEnd();it++) {
+      ret.push_front(it.value());
+    }
+    return ret;
+  }
+  for(QMultiMap<QString,int>::const_iterator it=d_section_order.constBegin();
+      it!=d_section_order.constEnd();it++) {
+    ret.push_front(d_symbols.name(it.value()));
+  }
+
+  return ret;
+}
+
+
+QStringList Profile::sectionIds(const QString &section) const
+{
+  QStringList ret;
+
+  if(!d_base.isNull()) {
+    QMap<QString,QPair<QString,QString> > names=LayeredBlockNames(section);
+    for(QMap<QString,QPair<QString,QString> >::const_iterator it=
+	  names.constBegin();it!=names.constEnd();it++) {
+      if(!it.value().second.isNull()) {
+	ret.push_back(it.value().second);
+      }
+    }
+    return ret;
+  }
+  QHash<int,SectionIndex>::const_iterator it=
+    d_section_index.constFind(d_symbols.symbol(section));
+  if(it==d_section_index.constEnd()) {
+    return ret;
+  }
+  const QMap<QString,int> &ids=it.value().ids;
+  for(QMap<QString,int>::const_iterator it1=ids.constBegin();
+      it1!=ids.constEnd();it1++) {
+    ret.push_back(it1.key());
+  }
+
+  return ret;
+}
+
+
+QString Profile::stringValue(const QString &section,const QString &tag,
+			     const QString &default_str,bool *found) const
+{
+  const ProfileValues *values=
+    Counted(ProfileStats::String,FindValues(section,tag));
+  if(found!=NULL) {
+    *found=values!=NULL;
+  }
+  if(values==NULL) {
+    return default_str;
+  }
+  return values->value(0);
+}
+
+
+QStringList Profile::stringValues(const QString &section,
+				  const QString &tag) const
+{
+  const ProfileValues *values=
+    Counted(ProfileStats::String,FindValues(section,tag));
+  if(values==NULL) {
+    return QStringList();
+  }
+  return values->toStrings();
+}
+
+
+QStringList Profile::stringValues(const QString &section,
+				  const QString &section_id,
+				  const QString &tag) const
+{
+  const ProfileValues *values=
+    Counted(ProfileStats::String,FindValues(section,section_id,tag));
+  if(values==NULL) {
+    return QStringList();
+  }
+  return values->toStrings();
+}
+
+
+int Profile::intValue(const QString &section,const QString &tag,
+		      int default_value,bool *found) const
+{
+  const ProfileValues *values=
+    Counted(ProfileStats::Int,FindValues(section,tag));
+  if(found!=NULL) {
+    *found=values!=NULL;
+  }
+  if(values==NULL) {
+    return default_value;
+  }
+  return values->intValues().first();
+}
+
+
+QList<int> Profile::intValues(const QString &section,const QString &tag) const
+{
+  const ProfileValues *values=
+    Counted(ProfileStats::Int,FindValues(section,tag));
+  if(values==NULL) {
+    return QList<int>();
+  }
+  return values->intValues();
+}
+
+
+QList<int> Profile::intValues(const QString &section,const QString &section_id,
+			      const QString &tag) const
+{
+  const ProfileValues *values=
+    Counted(ProfileStats::Int,FindValues(section,section_id,tag));
+  if(values==NULL) {
+    return QList<int>();
+  }
+  return values->intValues();
+}
+
+
+int Profile::hexValue(const QString &section,const QString &tag,
+		       int default_value,bool *found) const
+{
+  const ProfileValues *values=
+    Counted(ProfileStats::Hex,FindValues(section,tag));
+  if(found!=NULL) {
+    *found=values!=NULL;
+  }
+  if(values==NULL) {
+    return default_value;
+  }
+  return values->hexValues().first();
+}
+
+
+QList<int> Profile::hexValues(const QString &section,const QString &tag) const
+{
+  const ProfileValues *values=
+    Counted(ProfileStats::Hex,FindValues(section,tag));
+  if(values==NULL) {
+    return QList<int>();
+  }
+  return values->hexValues();
+}
+
+
+QList<int> Profile::hexValues(const QString &section,const QString &section_id,
+			      const QString &tag) const
+{
+  const ProfileValues *values=
+    Counted(ProfileStats::Hex,FindValues(section,section_id,tag));
+  if(values==NULL) {
+    return QList<int>();
+  }
+  return values->hexValues();
+}
+
+
+double Profile::doubleValue(const QString &section,const QString &tag,
+			    double default_value,bool *found) const
+{
+  const ProfileValues *values=
+    Counted(ProfileStats::Double,FindValues(section,tag));
+  if(found!=NULL) {
+    *found=values!=NULL;
+  }
+  if(values==NULL) {
+    return default_value;
+  }
+  return values->doubleValues().first();
+}
+
+
+QList<double> Profile::doubleValues(const QString &section,
+				    const QString &tag) const
+{
+  const ProfileValues *values=
+    Counted(ProfileStats::Double,FindValues(section,tag));
+  if(values==NULL) {
+    return QList<double>();
+  }
+  return values->doubleValues();
+}
+
+
+QList<double> Profile::doubleValues(const QString &section,
+				    const QString &section_id,
+				    const QString &tag) const
+{
+  const ProfileValues *values=
+    Counted(ProfileStats::Double,FindValues(section,section_id,tag));
+  if(values==NULL) {
+    return QList<double>();
+  }
+  return values->doubleValues();
+}
+
+
+bool Profile::boolValue(const QString &section,const QString &tag,
+			 bool default_value,bool *found) const
+{
+  const ProfileValues *values=
+    Counted(ProfileStats::Bool,FindValues(section,tag));
+  if(found!=NULL) {
+    *found=values!=NULL;
+  }
+  if(values==NULL) {
+    return default_value;
+  }
+  return values->boolValues().first();
+}
+
+
+QList<bool> Profile::boolValues(const QString &section,const QString &tag) const
+{
+  const ProfileValues *values=
+    Counted(ProfileStats::Bool,FindValues(section,tag));
+  if(values==NULL) {
+    return QList<bool>();
+  }
+  return values->boolValues();
+}
+
+
+QList<bool> Profile::boolValues(const QString &section,
+				const QString &section_id,
+				const QString &tag) const
+{
+  const ProfileValues *values=
+    Counted(ProfileStats::Bool,FindValues(section,section_id,tag));
+  if(values==NULL) {
+    return QList<bool>();
+  }
+  return values->boolValues();
+}
+
+
+QTime Profile::timeValue(const QString &section,const QString &tag,
+			   const QTime &default_value,bool *found) const
+{
+  const ProfileValues *values=
+    Counted(ProfileStats::Time,FindValues(section,tag));
+  if(found!=NULL) {
+    *found=values!=NULL;
+  }
+  if(values==NULL) {
+    return default_value;
+  }
+  return values->timeValues().first();
+}
+
+
+QList<QTime> Profile::timeValues(const QString &section,
+				 const QString &tag) const
+{
+  const ProfileValues *values=
+    Counted(ProfileStats::Time,FindValues(section,tag));
+  if(values==NULL) {
+    return QList<QTime>();
+  }
+  return values->timeValues();
+}
+
+
+QList<QTime> Profile::timeValues(const QString &section,
+				 const QString &section_id,
+				 const QString &tag) const
+{
+  const ProfileValues *values=
+    Counted(ProfileStats::Time,FindValues(section,section_id,tag));
+  if(values==NULL) {
+    return QList<QTime>();
+  }
+  return values->timeValues();
+}
+
+
+QHostAddress Profile::addressValue(const QString &section,const QString &tag,
+				  const QHostAddress &default_value,bool *found) const
+{
+  const ProfileValues *values=
+    Counted(ProfileStats::Address,FindValues(section,tag));
+  if(found!=NULL) {
+    *found=values!=NULL;
+  }
+  if(values==NULL) {
+    return default_value;
+  }
+  return values->addressValues().first();
+}
+
+
+QHostAddress Profile::addressValue(const QString &section,const QString &tag,
+				     const QString &default_value,bool *found) const
+{
+  return addressValue(section,tag,QHostAddress(default_value),found);
+}
+
+
+QList<QHostAddress> Profile::addressValues(const QString &section,
+					   const QString &tag) const
+{
+  const ProfileValues *values=
+    Counted(ProfileStats::Address,FindValues(section,tag));
+  if(values==NULL) {
+    return QList<QHostAddress>();
+  }
+  return values->addressValues();
+}
+
+
+QList<QHostAddress> Profile::addressValues(const QString &section,
+					   const QString &section_id,
+					   const QString &tag) const
+{
+  const ProfileValues *values=
+    Counted(ProfileStats::Address,FindValues(section,section_id,tag));
+  if(values==NULL) {
+    return QList<QHostAddress>();
+  }
+  return values->addressValues();
+}
+
+
+const QStringList &Profile::stringValuesRef(const QString &section,
+					    const QString &tag) const
+{
+  const ProfileValues *values=
+    Counted(ProfileStats::String,FindValues(section,tag));
+  if(values==NULL) {
+    return EmptyValues();
+  }
+  return values->stringValues();
+}
+
+
+const QStringList &Profile::stringValuesRef(const QString &section,
+					    const QString &section_id,
+					    const QString &tag) const
+{
+  const ProfileValues *values=
+    Counted(ProfileStats::String,FindValues(section,section_id,tag));
+  if(values==NULL) {
+    return EmptyValues();
+  }
+  return values->stringValues();
+}
+
+
+int Profile::valueCount(const QString &section,const QString &tag) const
+{
+  const ProfileValues *values=
+    Counted(ProfileStats::Count,FindValues(section,tag));
+  if(values==NULL) {
+    return 0;
+  }
+  return values->size();
+}
+
+
+int Profile::valueCount(const QString &section,const QString &section_id,
+			const QString &tag) const
+{
+  const ProfileValues *values=
+    Counted(ProfileStats::Count,FindValues(section,section_id,tag));
+  if(values==NULL) {
+    return 0;
+  }
+  return values->size();
+}
+
+
+QStringView Profile::valueAt(const QString &section,const QString &tag,
+			     int n) const
+{
+  const ProfileValues *values=
+    Counted(ProfileStats::String,FindValues(section,tag));
+  if((values==NULL)||(n<0)||(n>=values->size())) {
+    return QStringView();
+  }
+  return QStringView(values->stringValues().at(n));
+}
+
+
+QStringView Profile::valueAt(const QString &section,const QString &section_id,
+			     const QString &tag,int n) const
+{
+  const ProfileValues *values=
+    Counted(ProfileStats::String,FindValues(section,section_id,tag));
+  if((values==NULL)||(n<0)||(n>=values->size())) {
+    return QStringView();
+  }
+  return QStringView(values->stringValues().at(n));
+}
+
+
+int Profile::readIntValues(const QString &section,const QString &tag,
+			   int *values,int max,QList<int> *errors) const
+{
+  const ProfileValues *v=Counted(ProfileStats::Int,FindValues(section,tag));
+  if(v==NULL) {
+    return 0;
+  }
+  return v->toInts(values,max,errors);
+}
+
+
+int Profile::readHexValues(const QString &section,const QString &tag,
+			   int *values,int max,QList<int> *errors) const
+{
+  const ProfileValues *v=Counted(ProfileStats::Hex,FindValues(section,tag));
+  if(v==NULL) {
+    return 0;
+  }
+  return v->toHexes(values,max,errors);
+}
+
+
+int Profile::readDoubleValues(const QString &section,const QString &tag,
+			      double *values,int max,QList<int> *errors) const
+{
+  const ProfileValues *v=Counted(ProfileStats::Double,FindValues(section,tag));
+  if(v==NULL) {
+    return 0;
+  }
+  return v->toDoubles(values,max,errors);
+}
+
+
+int Profile::readIntValues(const QString &section,
+			   const QString &section_id,const QString &tag,
+			   int *values,int max,QList<int> *errors) const
+{
+  const ProfileValues *v=
+    Counted(ProfileStats::Int,FindValues(section,section_id,tag));
+  if(v==NULL) {
+    return 0;
+  }
+  return v->toInts(values,max,errors);
+}
+
+
+int Profile::readHexValues(const QString &section,
+			   const QString &section_id,const QString &tag,
+			   int *values,int max,QList<int> *errors) const
+{
+  const ProfileValues *v=
+    Counted(ProfileStats::Hex,FindValues(section,section_id,tag));
+  if(v==NULL) {
+    return 0;
+  }
+  return v->toHexes(values,max,errors);
+}
+
+
+int Profile::readDoubleValues(const QString &section,
+			      const QString &section_id,const QString &tag,
+			      double *values,int max,QList<int> *errors) const
+{
+  const ProfileValues *v=
+    Counted(ProfileStats::Double,FindValues(section,section_id,tag));
+  if(v==NULL) {
+    return 0;
+  }
+  return v->toDoubles(values,max,errors);
+}
+
+
+QString Profile::stringValue(const Key &key,const QString &default_value,
+			     bool *found) const
+{
+  const ProfileValues *values=Counted(ProfileStats::String,FindValues(key));
+  if(found!=NULL) {
+    *found=values!=NULL;
+  }
+  if(values==NULL) {
+    return default_value;
+  }
+  return values->value(0);
+}
+
+
+QStringList Profile::stringValues(const Key &key) const
+{
+  const ProfileValues *values=Counted(ProfileStats::String,FindValues(key));
+  if(values==NULL) {
+    return QStringList();
+  }
+  return values->toStrings();
+}
+
+
+const QStringList &Profile::stringValuesRef(const Key &key) const
+{
+  const ProfileValues *values=Counted(ProfileStats::String,FindValues(key));
+  if(values==NULL) {
+    return EmptyValues();
+  }
+  return values->stringValues();
+}
+
+
+int Profile::valueCount(const Key &key) const
+{
+  const ProfileValues *values=Counted(ProfileStats::Count,FindValues(key));
+  if(values==NULL) {
+    return 0;
+  }
+  return values->size();
+}
+
+
+QStringView Profile::valueAt(const Key &key,int n) const
+{
+  const ProfileValues *values=Counted(ProfileStats::String,FindValues(key));
+  if((values==NULL)||(n<0)||(n>=values->size())) {
+    return QStringView();
+  }
+  return QStringView(values->stringValues().at(n));
+}
+
+
+int Profile::readIntValues(const Key &key,int *values,int max,
+			   QList<int> *errors) const
+{
+  const ProfileValues *v=Counted(ProfileStats::Int,FindValues(key));
+  if(v==NULL) {
+    return 0;
+  }
+  return v->toInts(values,max,errors);
+}
+
+
+int Profile::readHexValues(const Key &key,int *values,int max,
+			   QList<int> *errors) const
+{
+  const ProfileValues *v=Counted(ProfileStats::Hex,FindValues(key));
+  if(v==NULL) {
+    return 0;
+  }
+  return v->toHexes(values,max,errors);
+}
+
+
+int Profile::readDoubleValues(const Key &key,double *values,int max,
+			      QList<int> *errors) const
+{
+  const ProfileValues *v=Counted(ProfileStats::Double,FindValues(key));
+  if(v==NULL) {
+    return 0;
+  }
+  return v->toDoubles(values,max,errors);
+}
+
+
+int Profile::intValue(const Key &key,int default_value,bool *found) const
+{
+  const ProfileValues *values=Counted(ProfileStats::Int,FindValues(key));
+  if(found!=NULL) {
+    *found=values!=NULL;
+  }
+  if(values==NULL) {
+    return default_value;
+  }
+  return values->intValues().first();
+}
+
+
+QList<int> Profile::intValues(const Key &key) const
+{
+  const ProfileValues *values=Counted(ProfileStats::Int,FindValues(key));
+  if(values==NULL) {
+    return QList<int>();
+  }
+  return values->intValues();
+}
+
+
+int Profile::hexValue(const Key &key,int default_value,bool *found) const
+{
+  const ProfileValues *values=Counted(ProfileStats::Hex,FindValues(key));
+  if(found!=NULL) {
+    *found=values!=NULL;
+  }
+  if(values==NULL) {
+    return default_value;
+  }
+  return values->hexValues().first();
+}
+
+
+QList<int> Profile::hexValues(const Key &key) const
+{
+  const ProfileValues *values=Counted(ProfileStats::Hex,FindValues(key));
+  if(values==NULL) {
+    return QList<int>();
+  }
+  return values->hexValues();
+}
+
+
+double Profile::doubleValue(const Key &key,double default_value,
+			    bool *found) const
+{
+  const ProfileValues *values=Counted(ProfileStats::Double,FindValues(key));
+  if(found!=NULL) {
+    *found=values!=NULL;
+  }
+  if(values==NULL) {
+    return default_value;
+  }
+  return values->doubleValues().first();
+}
+
+
+QList<double> Profile::doubleValues(const Key &key) const
+{
+  const ProfileValues *values=Counted(ProfileStats::Double,FindValues(key));
+  if(values==NULL) {
+    return QList<double>();
+  }
+  return values->doubleValues();
+}
+
+
+bool Profile::boolValue(const Key &key,bool default_value,bool *found) const
+{
+  const ProfileValues *values=Counted(ProfileStats::Bool,FindValues(key));
+  if(found!=NULL) {
+    *found=values!=NULL;
+  }
+  if(values==NULL) {
+    return default_value;
+  }
+  return values->boolValues().first();
+}
+
+
+QList<bool> Profile::boolValues(const Key &key) const
+{
+  const ProfileValues *values=Counted(ProfileStats::Bool,FindValues(key));
+  if(values==NULL) {
+    return QList<bool>();
+  }
+  return values->boolValues();
+}
+
+
+QTime Profile::timeValue(const Key &key,const QTime &default_value,
+			 bool *found) const
+{
+  const ProfileValues *values=Counted(ProfileStats::Time,FindValues(key));
+  if(found!=NULL) {
+    *found=values!=NULL;
+  }
+  if(values==NULL) {
+    return default_value;
+  }
+  return values->timeValues().first();
+}
+
+
+QList<QTime> Profile::timeValues(const Key &key) const
+{
+  const ProfileValues *values=Counted(ProfileStats::Time,FindValues(key));
+  if(values==NULL) {
+    return QList<QTime>();
+  }
+  return values->timeValues();
+}
+
+
+QHostAddress Profile::addressValue(const Key &key,
+				   const QHostAddress &default_value,
+				   bool *found) const
+{
+  const ProfileValues *values=Counted(ProfileStats::Address,FindValues(key));
+  if(found!=NULL) {
+    *found=values!=NULL;
+  }
+  if(values==NULL) {
+    return default_value;
+  }
+  return values->addressValues().first();
+}
+
+
+QList<QHostAddress> Profile::addressValues(const Key &key) const
+{
+  const ProfileValues *values=Counted(ProfileStats::Address,FindValues(key));
+  if(values==NULL) {
+    return QList<QHostAddress>();
+  }
+  return values->addressValues();
+}
+
+
+void Profile::clear()
+{
+  profile_source="";
+  d_blocks.clear();
+  d_section_index.clear();
+  d_section_order.clear();
+  d_lazy_blocks.clear();
+  d_lazy_errors.clear();
+  d_symbols.clear();
+  d_sources.clear();
+  if(d_stats!=NULL) {
+    d_stats->files.clear();
+  }
+  d_unkeyed_source=false;
+  d_generation=__Profile_NextGeneration();
+}
+
+
+QString Profile::dump() const
+{
+  QByteArray data;
+  QBuffer buffer(&data);
+
+  buffer.open(QIODevice::WriteOnly);
+  WriteDump(&buffer,NULL);
+  buffer.close();
+
+  return QString::fromUtf8(data);
+}
+
+
+bool Profile::dump(QIODevice *dev) const
+{
+  return WriteDump(dev,NULL);
+}
+
+
+bool Profile::dump(FILE *f) const
+{
+  return WriteDump(NULL,f);
+}
+
+
+//
+// Layers are read in place, with the topmost non-empty copy of each tag
+// in a block standing in for the copies beneath it. A profile with no base
+// is simply a stack of one.
+//
+bool Profile::WriteDump(QIODevice *dev,FILE *f) const
+{
+  __Profile_DumpWriter *writer=new __Profile_DumpWriter(dev,f);
+  QMap<QString,QPair<QString,QString> > names=LayeredBlockNames();
+
+  for(QMap<QString,QPair<QString,QString> >::const_iterator name_it=
+	names.constBegin();name_it!=names.constEnd();name_it++) {
+    const QString &section=name_it.value().first;
+    const QString &id=name_it.value().second;
+    writer->write("[",1);
+    writer->write(section);
+    writer->write("]\n",2);
+    if(d_use_section_ids) {
+      writer->write("Id=",3);
+      writer->write(id);
+      writer->write("\n",1);
+    }
+    QMap<QString,const ProfileValues *> tags;
+    for(const Profile *layer=this;layer!=NULL;layer=layer->d_base.data()) {
+      const Block *block=layer->FindBlock(section,id);
+      if(block==NULL) {
+	continue;
+      }
+      for(Block::const_iterator it=block->constBegin();it!=block->constEnd();
+	  it++) {
+	QMap<QString,const ProfileValues *>::iterator it1=
+	  tags.find(layer->d_symbols.name(it.key()));
+	if(it1==tags.end()) {
+	  tags.insert(layer->d_symbols.name(it.key()),&it.value());
+	}
+	else {
+	  if(it1.value()->size()==0) {
+	    it1.value()=&it.value();
+	  }
+	}
+      }
+    }
+    for(QMap<QString,const ProfileValues *>::const_iterator it=
+	  tags.constBegin();it!=tags.constEnd();it++) {
+      if(d_use_section_ids&&(it.key()=="Id")) {
+	continue;
+      }
+      const ProfileValues *values=it.value();
+      for(int j=0;j<values->size();j++) {
+	int len=0;
+	const char *data=values->utf8(j,&len);
+	writer->write(it.key());
+	writer->write("=",1);
+	writer->write(data,len);
+	writer->write("\n",1);
+      }
+    }
+  }
+  bool ret=writer->flush();
+  delete writer;
+
+  return ret;
+}
+
+
+void Profile::ProcessBlock(const QString &name,
+			   const QMap<QString,ProfileValues> &lines)
+{
+  if(lines.isEmpty()) {
+    return;
+  }
+
+  int id=-1;
+  if(d_use_section_ids) {
+    QMap<QString,ProfileValues>::const_iterator it=lines.constFind("Id");
+    if((it!=lines.constEnd())&&(it.value().size()>0)) {
+      id=d_symbols.intern(it.value().value(0));
+    }
+    else {
+      id=d_symbols.intern(__PROFILE_DEFAULT_SECTION_ID);
+    }
+  }
+
+  d_generation=__Profile_NextGeneration();
+  quint64 key=__Profile_BlockKey(d_symbols.intern(name),id);
+  if(!d_lazy_blocks.isEmpty()) {
+    Materialize(key);
+    d_lazy_blocks.remove(key);
+  }
+  QHash<quint64,Block>::iterator block_it=d_blocks.find(key);
+  if(block_it==d_blocks.end()) {
+    block_it=d_blocks.insert(key,Block());
+    IndexBlock(key);
+  }
+  Block &block=block_it.value();
+  for(QMap<QString,ProfileValues>::const_iterator it=lines.constBegin();
+      it!=lines.constEnd();it++) {
+    block[d_symbols.intern(it.key())].append(it.value());
+  }
+}
+
+
+const ProfileValues *Profile::FindValues(const QString &section,
+					 const QString &tag) const
+{
+  int layer=0;
+  const ProfileValues *values=
+    FindLayerValues(section,QString(),tag,false,&layer);
+  if(values!=NULL) {
+    CountLayer(layer);
+  }
+  return values;
+}
+
+
+const ProfileValues *Profile::FindValues(const QString &section,
+					 const QString &section_id,
+					 const QString &tag) const
+{
+  int layer=0;
+  const ProfileValues *values=
+    FindLayerValues(section,section_id,tag,true,&layer);
+  if(values!=NULL) {
+    CountLayer(layer);
+  }
+  return values;
+}
+
+
+const ProfileValues *Profile::FindValues(int section,int id,int tag) const
+{
+  quint64 key=__Profile_BlockKey(section,id);
+  if(!d_lazy_blocks.isEmpty()) {
+    Materialize(key);
+  }
+  QHash<quint64,Block>::const_iterator it=d_blocks.constFind(key);
+  if(it==d_blocks.constEnd()) {
+    return NULL;
+  }
+  Block::const_iterator it1=it.value().constFind(tag);
+  if((it1==it.value().constEnd())||(it1.value().size()==0)) {
+    return NULL;
+  }
+  return &it1.value();
+}
+
+
+const Profile::Block *Profile::FindBlock(const QString &section,
+					 const QString &section_id) const
+{
+  int sect=d_symbols.symbol(section);
+  int id=-1;
+  if(sect<0) {
+    return NULL;
+  }
+  if(!section_id.isNull()) {
+    if((id=d_symbols.symbol(section_id))<0) {
+      return NULL;
+    }
+  }
+  quint64 key=__Profile_BlockKey(sect,id);
+  if(!d_lazy_blocks.isEmpty()) {
+    Materialize(key);
+  }
+  QHash<quint64,Block>::const_iterator it=d_blocks.constFind(key);
+  if(it==d_blocks.constEnd()) {
+    return NULL;
+  }
+  return &it.value();
+}
+
+
+const ProfileValues *Profile::FindValues(const Block *block,
+					 const QString &tag) const
+{
+  int sym=d_symbols.symbol(tag);
+  if(sym<0) {
+    return NULL;
+  }
+  Block::const_iterator it=block->constFind(sym);
+  if((it==block->constEnd())||(it.value().size()==0)) {
+    return NULL;
+  }
+  return &it.value();
+}
+
+
+const QStringList &Profile::EmptyValues()
+{
+  static const QStringList empty;
+
+  return empty;
+}
+
+
+//
+// A Key remembers the value slot it was last resolved to, and the Profile
+// and generation it was resolved against. It is looked up again only when
+// either has changed. Keys carry no locking and so should not be shared
+// between threads.
+//
+const ProfileValues *Profile::FindValues(const Key &key) const
+{
+  quint64 generation=LayerGeneration();
+  if((key.d_profile!=this)||(key.d_generation!=generation)) {
+    key.d_values=FindLayerValues(key.d_section,key.d_section_id,key.d_tag,
+				 key.d_use_section_id,&key.d_layer);
+    key.d_profile=this;
+    key.d_generation=generation;
+  }
+  if(key.d_values!=NULL) {
+    CountLayer(key.d_layer);
+  }
+  return key.d_values;
+}
+
+
+const ProfileValues *Profile::FindLayerValues(const QString &section,
+					      const QString &section_id,
+					      const QString &tag,
+					      bool use_section_id,
+					      int *layer) const
+{
+  const Profile *p=this;
+
+  for(int i=0;p!=NULL;i++) {
+    int sect=p->d_symbols.symbol(section);
+    int id=use_section_id?p->d_symbols.symbol(section_id):-1;
+    int sym=p->d_symbols.symbol(tag);
+    if((sect>=0)&&(sym>=0)&&((id>=0)||(!use_section_id))) {
+      const ProfileValues *values=p->FindValues(sect,id,sym);
+      if(values!=NULL) {
+	*layer=i;
+	return values;
+      }
+    }
+    p=p->d_base.data();
+  }
+
+  return NULL;
+}
+
+
+void Profile::CountLayer(int layer) const
+{
+  if(d_stats!=NULL) {
+    d_stats->layer_hits[qMin(layer,PROFILESTATS_MAX_LAYERS-1)].
+      fetchAndAddRelaxed(1);
+  }
+}
+
+
+//
+// Generation numbers only ever increase, so the largest one in the stack
+// changes whenever any of its layers does.
+//
+quint64 Profile::LayerGeneration() const
+{
+  quint64 ret=d_generation;
+
+  for(const Profile *layer=d_base.data();layer!=NULL;
+      layer=layer->d_base.data()) {
+    ret=qMax(ret,layer->d_generation);
+  }
+
+  return ret;
+}
+
+
+//
+// Merge the stack into a single standalone profile, starting from the
+// deepest layer, for the operations that need to see all of it at once.
+//
+Profile *Profile::Flattened() const
+{
+  QList<const Profile *> layers;
+  for(const Profile *layer=this;layer!=NULL;layer=layer->d_base.data()) {
+    layers.push_front(layer);
+  }
+
+  Profile *ret=new Profile(d_use_section_ids);
+  for(int i=0;i<layers.size();i++) {
+    const Profile *layer=layers.at(i);
+    layer->MaterializeAll();
+    for(QHash<quint64,Block>::const_iterator it=layer->d_blocks.constBegin();
+	it!=layer->d_blocks.constEnd();it++) {
+      int sect=ret->d_symbols.
+	intern(layer->d_symbols.name(__Profile_KeySection(it.key())));
+      int id=__Profile_KeyId(it.key());
+      if(id>=0) {
+	id=ret->d_symbols.intern(layer->d_symbols.name(id));
+      }
+      quint64 key=__Profile_BlockKey(sect,id);
+      QHash<quint64,Block>::iterator block_it=ret->d_blocks.find(key);
+      if(block_it==ret->d_blocks.end()) {
+	block_it=ret->d_blocks.insert(key,Block());
+	ret->IndexBlock(key);
+      }
+      for(Block::const_iterator it1=it.value().constBegin();
+	  it1!=it.value().constEnd();it1++) {
+	if(it1.value().size()>0) {
+	  block_it.value()[ret->d_symbols.intern(layer->d_symbols.
+						 name(it1.key()))]=it1.value();
+	}
+      }
+    }
+    ret->d_sources+=layer->d_sources;
+    ret->d_unkeyed_source=ret->d_unkeyed_source||layer->d_unkeyed_source;
+  }
+  ret->profile_source=profile_source;
+
+  return ret;
+}
+
+
+const ProfileValues *Profile::Counted(ProfileStats::Type type,
+				     const ProfileValues *values) const
+{
+  if(d_stats!=NULL) {
+    if(values==NULL) {
+      d_stats->misses[type].fetchAndAddRelaxed(1);
+    }
+    else {
+      d_stats->hits[type].fetchAndAddRelaxed(1);
+    }
+  }
+  return values;
+}
+
+
+void Profile::AddFileStats(const QString &path,qint64 bytes,qint64 nsecs,
+			   bool cached)
+{
+  if(d_stats!=NULL) {
+    ProfileStats::File file;
+    file.path=path;
+    file.bytes=bytes;
+    file.nsecs=nsecs;
+    file.cached=cached;
+    d_stats->files.push_back(file);
+  }
+}
+
+
+QString Profile::BlockName(quint64 key) const
+{
+  if(__Profile_KeyId(key)<0) {
+    return d_symbols.name(__Profile_KeySection(key));
+  }
+  return d_symbols.name(__Profile_KeySection(key))+
+    __PROFILE_SECTION_ID_DELIMITER+d_symbols.name(__Profile_KeyId(key));
+}
+
+
+//
+// The lines that open a section in dump() output
+//
+QStringList Profile::BlockHeader(quint64 key) const
+{
+  QStringList ret;
+
+  ret.push_back("["+d_symbols.name(__Profile_KeySection(key))+"]");
+  if(d_use_section_ids) {
+    ret.push_back("Id="+d_symbols.name(__Profile_KeyId(key)));
+  }
+
+  return ret;
+}
+
+
+//
+// The blocks of the whole stack of layers, keyed and ordered by their
+// BlockName(), with the section name and ID of each. Limited to the
+// blocks of one section when 'section' is given.
+//
+QMap<QString,QPair<QString,QString> >
+Profile::LayeredBlockNames(const QString &section) const
+{
+  QMap<QString,QPair<QString,QString> > ret;
+
+  for(const Profile *layer=this;layer!=NULL;layer=layer->d_base.data()) {
+    QHash<int,SectionIndex>::const_iterator it=
+      layer->d_section_index.constBegin();
+    QHash<int,SectionIndex>::const_iterator end=
+      layer->d_section_index.constEnd();
+    if(!section.isNull()) {
+      it=layer->d_section_index.constFind(layer->d_symbols.symbol(section));
+      if(it!=end) {
+	end=it;
+	end++;
+      }
+    }
+    for(;it!=end;it++) {
+      QString name=layer->d_symbols.name(it.key());
+      const QMap<QString,int> &ids=it.value().ids;
+      if(ids.isEmpty()) {
+	ret[name]=QPair<QString,QString>(name,QString());
+      }
+      for(QMap<QString,int>::const_iterator it1=ids.constBegin();
+	  it1!=ids.constEnd();it1++) {
+	ret[name+__PROFILE_SECTION_ID_DELIMITER+it1.key()]=
+	  QPair<QString,QString>(name,it1.key());
+      }
+    }
+  }
+
+  return ret;
+}
+
+
+QList<quint64> Profile::SortedBlockKeys() const
+{
+  QMap<QString,quint64> sorted;
+
+  for(QHash<quint64,Block>::const_iterator it=d_blocks.constBegin();
+      it!=d_blocks.constEnd();it++) {
+    sorted[BlockName(it.key())]=it.key();
+  }
+
+  return sorted.values();
+}
+
+
+void Profile::ProcessBlocks(const BlockList &blocks)
+{
+  for(int i=0;i<blocks.size();i++) {
+    ProcessBlock(blocks.at(i).first,blocks.at(i).second);
+  }
+}
+
+
+//
+// Drop the named sections and merge them back together from the complete
+// list of sources, in load order. Blocks for any other section are left
+// untouched.
+//
+void Profile::RebuildSections(const QList<const BlockList *> &sources,
+			      const QSet<QString> &sections)
+{
+  QSet<int> syms;
+  for(QSet<QString>::const_iterator it=sections.constBegin();
+      it!=sections.constEnd();it++) {
+    int sym=d_symbols.symbol(*it);
+    if(sym>=0) {
+      syms.insert(sym);
+    }
+  }
+  QHash<quint64,Block>::iterator it=d_blocks.begin();
+  while(it!=d_blocks.end()) {
+    if(syms.contains(__Profile_KeySection(it.key()))) {
+      d_lazy_blocks.remove(it.key());
+      it=d_blocks.erase(it);
+    }
+    else {
+      ++it;
+    }
+  }
+  for(QSet<int>::const_iterator it1=syms.constBegin();it1!=syms.constEnd();
+      it1++) {
+    UnindexSection(*it1);
+  }
+
+  for(int i=0;i<sources.size();i++) {
+    const BlockList *blocks=sources.at(i);
+    for(int j=0;j<blocks->size();j++) {
+      if(sections.contains(blocks->at(j).first)) {
+	ProcessBlock(blocks->at(j).first,blocks->at(j).second);
+      }
+    }
+  }
+  d_generation=__Profile_NextGeneration();
+}
+
+
+//
+// sections() lists names in descending order of the first composite
+// "section|id" key each one has, and sectionIds() lists IDs in ascending
+// order. Keeping each section's IDs sorted, and ordering the sections on
+// their smallest ID, lets both be read straight out of the index.
+//
+void Profile::IndexBlock(quint64 key)
+{
+  int sect=__Profile_KeySection(key);
+  int id=__Profile_KeyId(key);
+  SectionIndex &index=d_section_index[sect];
+
+  QString order_key=d_symbols.name(sect);
+  if(id>=0) {
+    index.ids[d_symbols.name(id)]=id;
+    order_key+=__PROFILE_SECTION_ID_DELIMITER+index.ids.firstKey();
+  }
+  if(order_key!=index.order_key) {
+    if(!index.order_key.isEmpty()) {
+      d_section_order.remove(index.order_key,sect);
+    }
+    d_section_order.insert(order_key,sect);
+    index.order_key=order_key;
+  }
+}
+
+
+void Profile::UnindexSection(int section)
+{
+  QHash<int,SectionIndex>::iterator it=d_section_index.find(section);
+  if(it!=d_section_index.end()) {
+    d_section_order.remove(it.value().order_key,section);
+    d_section_index.erase(it);
+  }
+}
+
+
+void Profile::RebuildIndex()
+{
+  d_section_index.clear();
+  d_section_order.clear();
+  for(QHash<quint64,Block>::const_iterator it=d_blocks.constBegin();
+      it!=d_blocks.constEnd();it++) {
+    IndexBlock(it.key());
+  }
+}
+
+
+bool Profile::ReadFile(const QString &filename,BlockList *blocks,
+		       QString *err_msg,SourceFile *src,bool *cached)
+{
+  if(src!=NULL) {
+    StatFile(filename,src);
+  }
+  if(cached!=NULL) {
+    *cached=false;
+  }
+  QFile data(filename);
+  if(!data.open(QFile::ReadOnly)) {
+    if(err_msg!=NULL) {
+      *err_msg="unable to open file";
+    }
+    return false;
+  }
+
+  //
+  // A file that is unchanged since some Profile in this process last
+  // parsed it is taken from the shared cache. The blocks are implicitly
+  // shared, so every Profile loading it ends up holding the same values.
+  //
+  CachedFile entry;
+  bool use_cache=(fileCacheLimit()>0)&&IdentifyFile(&data,&entry);
+  if(use_cache&&FindCachedFile(filename,entry,blocks)) {
+    if(cached!=NULL) {
+      *cached=true;
+    }
+    return true;
+  }
+
+  //
+  // Map the file and parse the UTF-8 in place. Things that can't be mapped
+  // (pipes, procfs entries, etc) get read into a buffer instead.
+  //
+  uchar *mem=NULL;
+  if(data.size()>0) {
+    mem=data.map(0,data.size());
+  }
+  if(mem!=NULL) {
+    ParseBuffer((const char *)mem,data.size(),blocks);
+    data.unmap(mem);
+  }
+  else {
+    QByteArray bytes=data.readAll();
+    ParseBuffer(bytes.constData(),bytes.size(),blocks);
+  }
+  if(use_cache) {
+    entry.blocks=*blocks;
+    entry.bytes=BlockListBytes(*blocks);
+    AddCachedFile(filename,entry);
+  }
+
+  return true;
+}
+
+
+QMutex *Profile::FileCacheMutex()
+{
+  static QMutex mutex;
+
+  return &mutex;
+}
+
+
+Profile::FileCacheData *Profile::FileCache()
+{
+  static FileCacheData cache={QHash<QString,CachedFile>(),0,0};
+
+  return &cache;
+}
+
+
+//
+// Identify the file actually opened, rather than whatever the path
+// points to now, so that a file replaced while it was being read is
+// never cached under the new file's identity.
+//
+bool Profile::IdentifyFile(QFile *file,CachedFile *entry)
+{
+  struct stat st;
+
+  if(fstat(file->handle(),&st)!=0) {
+    return false;
+  }
+  if(!S_ISREG(st.st_mode)) {
+    return false;
+  }
+  entry->device=st.st_dev;
+  entry->inode=st.st_ino;
+  entry->size=st.st_size;
+  entry->mtime=(qint64)st.st_mtim.tv_sec*1000000000+st.st_mtim.tv_nsec;
+  entry->used=0;
+  entry->bytes=0;
+
+  return true;
+}
+
+
+bool Profile::FindCachedFile(const QString &filename,const CachedFile &entry,
+			     BlockList *blocks)
+{
+  QMutexLocker locker(FileCacheMutex());
+  FileCacheData *cache=FileCache();
+  QHash<QString,CachedFile>::iterator it=cache->files.find(filename);
+
+  if(it==cache->files.end()) {
+    return false;
+  }
+  if((it.value().device!=entry.device)||(it.value().inode!=entry.inode)||
+     (it.value().size!=entry.size)||(it.value().mtime!=entry.mtime)) {
+    cache->bytes-=it.value().bytes;
+    cache->files.erase(it);
+    return false;
+  }
+  it.value().used=++cache->uses;
+  *blocks=it.value().blocks;
+
+  return true;
+}
+
+
+void Profile::AddCachedFile(const QString &filename,const CachedFile &entry)
+{
+  QMutexLocker locker(FileCacheMutex());
+  FileCacheData *cache=FileCache();
+
+  if(entry.bytes>__profile_file_cache_limit.loadAcquire()) {
+    return;
   }
-  QList<QHostAddress> ret;
-  QStringList values=block.value(tag);
-  for(int i=0;i<values.size();i++) {
-    ret.push_back(QHostAddress(values.at(i)));
+  QHash<QString,CachedFile>::iterator it=cache->files.find(filename);
+  if(it!=cache->files.end()) {
+    cache->bytes-=it.value().bytes;
+    cache->files.erase(it);
   }
-  return ret;
+  it=cache->files.insert(filename,entry);
+  it.value().used=++cache->uses;
+  cache->bytes+=entry.bytes;
+  TrimFileCache(cache);
 }
 
 
-QList<QHostAddress> Profile::addressValues(const QString &section,
-					   const QString &section_id,
-					   const QString &tag)
+//
+// Drop least recently used files until the cache fits its limit. The
+// cache is expected to hold tens of files, not thousands, so a linear
+// search for the oldest one is fine.
+//
+void Profile::TrimFileCache(FileCacheData *cache)
 {
-  QList<QHostAddress> ret;
-  
-  QMap<QString,QStringList> block=
-    d_blocks.value(section+__PROFILE_SECTION_ID_DELIMITER+section_id);
-  if(block.size()==0) {
-    return ret;
+  while(cache->bytes>__profile_file_cache_limit.loadAcquire()) {
+    QHash<QString,CachedFile>::iterator oldest=cache->files.begin();
+    for(QHash<QString,CachedFile>::iterator it=cache->files.begin();
+	it!=cache->files.end();it++) {
+      if(it.value().used<oldest.value().used) {
+	oldest=it;
+      }
+    }
+    cache->bytes-=oldest.value().bytes;
+    cache->files.erase(oldest);
   }
-  QStringList values=block.value(tag);
-  for(int i=0;i<values.size();i++) {
-    ret.push_back(QHostAddress(values.at(i)));
+}
+
+
+//
+// An estimate of the heap held by a parsed file, counted the same way as
+// ProfileStats::heapBytes()
+//
+qint64 Profile::BlockListBytes(const BlockList &blocks)
+{
+  qint64 ret=PROFILESTATS_ARRAY_HEADER_BYTES+
+    PROFILESTATS_POINTER_BYTES*blocks.size();
+
+  for(int i=0;i<blocks.size();i++) {
+    const QMap<QString,ProfileValues> &lines=blocks.at(i).second;
+    ret+=ProfileStats::stringBytes(blocks.at(i).first)+
+      PROFILESTATS_HASH_NODE_BYTES*lines.size();
+    for(QMap<QString,ProfileValues>::const_iterator it=lines.constBegin();
+	it!=lines.constEnd();it++) {
+      ret+=ProfileStats::stringBytes(it.key())+it.value().heapBytes();
+    }
   }
-  
+
   return ret;
 }
 
 
-void Profile::clear()
+void Profile::StatFile(const QString &filename,SourceFile *src)
 {
-  profile_source="";
-  d_blocks.clear();
+  QFileInfo info(filename);
+
+  src->path=filename;
+  if(info.isFile()&&info.isReadable()) {
+    src->size=info.size();
+    src->mtime=info.lastModified().toMSecsSinceEpoch();
+  }
+  else {
+    src->size=-1;
+    src->mtime=-1;
+  }
 }
 
 
-QString Profile::dump() const
+//
+// A compiled profile is current only if globbing its sources again turns
+// up exactly the same files, in the same order, each with the same size
+// and modification time as when it was compiled.
+//
+bool Profile::SourcesCurrent(const QList<Source> &sources)
 {
-  QString ret;
-  
-  for(QMap<QString,QMap<QString,QStringList> >::const_iterator it0=
-	d_blocks.begin();it0!=d_blocks.end();it0++) {
-    QStringList section=it0.key().split("|");
-    ret+=QString::asprintf("[%s]\n",section.first().toUtf8().constData());
-    if(d_use_section_ids) {
-      ret+=QString::asprintf("Id=%s\n",section.last().toUtf8().constData());
-    }
-    for(QMap<QString,QStringList>::const_iterator it1=it0.value().begin();
-	it1!=it0.value().end();it1++) {
-      for(int i=0;i<it1.value().size();i++) {
-	if((!d_use_section_ids)||(it1.key()!="Id")) {
-	  ret+=QString::asprintf("%s=%s\n",it1.key().toUtf8().constData(),
-				 it1.value().at(i).toUtf8().constData());
-	}
+  for(int i=0;i<sources.size();i++) {
+    const Source &source=sources.at(i);
+    QStringList paths;
+    if(source.glob_template.isEmpty()) {
+      paths.push_back(source.path);
+    }
+    else {
+      QDir dir(source.path);
+      QStringList name_filters;
+      name_filters.push_back(source.glob_template);
+      QStringList filenames=dir.entryList(name_filters,QDir::Files,QDir::Name);
+      for(int j=0;j<filenames.size();j++) {
+	paths.push_back(dir.path()+"/"+filenames.at(j));
+      }
+    }
+    if(paths.size()!=source.files.size()) {
+      return false;
+    }
+    for(int j=0;j<paths.size();j++) {
+      SourceFile src;
+      StatFile(paths.at(j),&src);
+      if((source.files.at(j).path!=src.path)||
+	 (source.files.at(j).size!=src.size)||
+	 (source.files.at(j).mtime!=src.mtime)) {
+	return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+
+void Profile::SetSource(const QString &path,const QString &glob_template,
+			const QList<SourceFile> &files)
+{
+  for(int i=0;i<d_sources.size();i++) {
+    if((d_sources.at(i).path==path)&&
+       (d_sources.at(i).glob_template==glob_template)) {
+      d_sources[i].files=files;
+      return;
+    }
+  }
+  Source source;
+  source.path=path;
+  source.glob_template=glob_template;
+  source.files=files;
+  d_sources.push_back(source);
+}
+
+
+bool Profile::ReadCompiled(const QByteArray &data,QString *err_msg)
+{
+  quint32 magic=0;
+  quint32 version=0;
+  quint32 flags=0;
+  quint64 length=0;
+  quint64 checksum=0;
+
+  //
+  // Header
+  //
+  if(data.size()<__PROFILE_COMPILED_HEADER_SIZE) {
+    if(err_msg!=NULL) {
+      *err_msg="not a compiled profile";
+    }
+    return false;
+  }
+  QDataStream hdr(QByteArray::fromRawData(data.constData(),
+					  __PROFILE_COMPILED_HEADER_SIZE));
+  hdr.setByteOrder(QDataStream::LittleEndian);
+  hdr>>magic>>version>>flags>>length>>checksum;
+  if(magic!=__PROFILE_COMPILED_MAGIC) {
+    if(err_msg!=NULL) {
+      *err_msg="not a compiled profile";
+    }
+    return false;
+  }
+  if(version!=__PROFILE_COMPILED_VERSION) {
+    if(err_msg!=NULL) {
+      *err_msg="unsupported compiled profile version";
+    }
+    return false;
+  }
+  const char *payload=data.constData()+__PROFILE_COMPILED_HEADER_SIZE;
+  if((length!=(quint64)(data.size()-__PROFILE_COMPILED_HEADER_SIZE))||
+     (checksum!=__Profile_Checksum(payload,length))) {
+    if(err_msg!=NULL) {
+      *err_msg="compiled profile is corrupt";
+    }
+    return false;
+  }
+  if(((flags&__PROFILE_COMPILED_FLAG_SECTION_IDS)!=0)!=d_use_section_ids) {
+    if(err_msg!=NULL) {
+      *err_msg="compiled profile has a different section ID mode";
+    }
+    return false;
+  }
+
+  //
+  // Sources
+  //
+  QDataStream in(QByteArray::fromRawData(payload,length));
+  in.setVersion(QDataStream::Qt_5_0);
+  in.setByteOrder(QDataStream::LittleEndian);
+  quint32 count=0;
+  QList<Source> sources;
+  in>>count;
+  for(quint32 i=0;(i<count)&&(in.status()==QDataStream::Ok);i++) {
+    Source source;
+    quint32 files=0;
+    in>>source.path>>source.glob_template>>files;
+    for(quint32 j=0;(j<files)&&(in.status()==QDataStream::Ok);j++) {
+      SourceFile src;
+      in>>src.path>>src.size>>src.mtime;
+      source.files.push_back(src);
+    }
+    sources.push_back(source);
+  }
+  if(in.status()!=QDataStream::Ok) {
+    if(err_msg!=NULL) {
+      *err_msg="compiled profile is corrupt";
+    }
+    return false;
+  }
+  if(!SourcesCurrent(sources)) {
+    if(err_msg!=NULL) {
+      *err_msg="compiled profile is out of date";
+    }
+    return false;
+  }
+
+  //
+  // Symbols and blocks
+  //
+  ProfileSymbols symbols;
+  QHash<quint64,Block> blocks;
+  bool ok=true;
+  in>>count;
+  for(quint32 i=0;(i<count)&&(in.status()==QDataStream::Ok)&&ok;i++) {
+    QString name;
+    in>>name;
+    ok=symbols.intern(name)==(int)i;
+  }
+  in>>count;
+  for(quint32 i=0;(i<count)&&(in.status()==QDataStream::Ok)&&ok;i++) {
+    quint64 key=0;
+    quint32 tags=0;
+    in>>key>>tags;
+    int sect=__Profile_KeySection(key);
+    int id=__Profile_KeyId(key);
+    ok=(sect>=0)&&(sect<symbols.size())&&
+      (d_use_section_ids?((id>=0)&&(id<symbols.size())):(id==-1));
+    Block &block=blocks[key];
+    for(quint32 j=0;(j<tags)&&(in.status()==QDataStream::Ok)&&ok;j++) {
+      qint32 tag=-1;
+      quint32 values=0;
+      in>>tag>>values;
+      ok=(tag>=0)&&(tag<symbols.size());
+      ProfileValues &vals=block[tag];
+      for(quint32 k=0;(k<values)&&(in.status()==QDataStream::Ok)&&ok;k++) {
+	QByteArray value;
+	in>>value;
+	vals.append(value.constData(),value.size());
+      }
+    }
+  }
+  if((!ok)||(in.status()!=QDataStream::Ok)) {
+    if(err_msg!=NULL) {
+      *err_msg="compiled profile is corrupt";
+    }
+    return false;
+  }
+
+  clear();
+  d_symbols=symbols;
+  d_blocks=blocks;
+  RebuildIndex();
+  d_sources=sources;
+
+  return true;
+}
+
+
+void Profile::ParseBuffer(const char *data,qint64 len,BlockList *blocks)
+{
+  //
+  // UTF-16 and UTF-32 text is decoded by QTextStream, as all files used to
+  // be, and then parsed as UTF-8 like everything else. A UTF-8 byte order
+  // mark is simply skipped.
+  //
+  if(__Profile_IsWideText(data,len)) {
+    QByteArray bytes=QByteArray::fromRawData(data,len);
+    QTextStream in(bytes,QIODevice::ReadOnly);
+    QString line;
+    QByteArray utf8;
+    in.setAutoDetectUnicode(true);
+    while(in.readLineInto(&line)) {
+      utf8+=line.trimmed().toUtf8();
+      utf8+="\n";
+    }
+    ParseChunk(utf8.constData(),utf8.size(),blocks);
+    return;
+  }
+  if((len>=3)&&(memcmp(data,"\xEF\xBB\xBF",3)==0)) {
+    data+=3;
+    len-=3;
+  }
+
+  //
+  // Large inputs are cut at section headers and the pieces tokenized in
+  // parallel. The chunk results are concatenated in file order, so the
+  // caller sees the same block list as for a serial parse.
+  //
+  QList<qint64> offsets=ChunkOffsets(data,len);
+  if(offsets.size()==1) {
+    ParseChunk(data,len,blocks);
+    return;
+  }
+  QVector<BlockList> chunks(offsets.size());
+  BlockList *results=chunks.data();
+  __Profile_ParallelFor(chunks.size(),[&](int n) {
+      qint64 start=offsets.at(n);
+      qint64 end=(n<(offsets.size()-1))?offsets.at(n+1):len;
+      ParseChunk(data+start,end-start,results+n);
+    });
+  for(int i=0;i<chunks.size();i++) {
+    blocks->append(chunks.at(i));
+  }
+}
+
+
+void Profile::ParseChunk(const char *data,qint64 len,BlockList *blocks)
+{
+  QString block_name;
+  QMap<QString,ProfileValues> block_lines;
+  ProfileScanner scanner(data,len);
+
+  while(scanner.nextLine()) {
+    switch(scanner.lineType()) {
+    case ProfileScanner::Section:
+      if(!block_name.isEmpty()) {
+	blocks->push_back(qMakePair(block_name,block_lines));
+      }
+      block_name=
+	QString::fromUtf8(scanner.lineStart()+1,scanner.lineLength()-2);
+      block_lines.clear();
+      break;
+
+    case ProfileScanner::Value:
+      if(scanner.separator()==NULL) {
+	block_lines[QString::fromUtf8(scanner.lineStart(),
+				      scanner.lineLength())].append("",0);
+      }
+      else {
+	block_lines[QString::fromUtf8(scanner.lineStart(),
+			      scanner.separator()-scanner.lineStart())].
+	  append(scanner.separator()+1,
+		 scanner.lineEnd()-scanner.separator()-1);
+      }
+      break;
+
+    case ProfileScanner::Blank:
+    case ProfileScanner::Comment:
+      break;
+    }
+  }
+  if(!block_name.isEmpty()) {
+    blocks->push_back(qMakePair(block_name,block_lines));
+  }
+}
+
+
+QList<qint64> Profile::ChunkOffsets(const char *data,qint64 len)
+{
+  QList<qint64> ret;
+
+  ret.push_back(0);
+  int chunks=qMin((qint64)QThread::idealThreadCount(),
+		  len/__PROFILE_PARALLEL_CHUNK_SIZE);
+  for(int i=1;i<chunks;i++) {
+    //
+    // Advance to the start of the next section header line
+    //
+    qint64 pos=qMax(ret.last(),len*i/chunks);
+    while(pos<len) {
+      const char *eol=(const char *)memchr(data+pos,'\n',len-pos);
+      if(eol==NULL) {
+	pos=len;
+	break;
+      }
+      pos=eol-data+1;
+      const char *next=(const char *)memchr(data+pos,'\n',len-pos);
+      qint64 first=pos;
+      qint64 last=(next==NULL)?len:(next-data);
+      while((first<last)&&__Profile_IsSpace(data[first])) {
+	first++;
+      }
+      while((last>first)&&__Profile_IsSpace(data[last-1])) {
+	last--;
       }
+      if(((last-first)>=2)&&(data[first]=='[')&&(data[last-1]==']')) {
+	pos=first;
+	break;
+      }
+    }
+    if(pos>=len) {
+      break;
+    }
+    if(pos>ret.last()) {
+      ret.push_back(pos);
     }
   }
 
@@ -601,34 +2900,343 @@ QString Profile::dump() const
 }
 
 
-void Profile::ProcessBlock(const QString &name,
-			   const QMap<QString,QStringList> &lines)
+//
+// The mapping outlives the file descriptor, so the file is closed as soon
+// as it is mapped; a large conf.d tree then costs no descriptors at all.
+//
+//
+// A mapped file is kept open, both because closing it would drop the
+// mapping and so that isCurrent() can check the file actually mapped
+// rather than whatever its path names now.
+//
+Profile::LazyBuffer::LazyBuffer(QFile *file)
 {
-  QString block_name=name;
-  if(d_use_section_ids) {
-    QStringList ids=lines.value("Id");
-    QString id=__PROFILE_DEFAULT_SECTION_ID;
-    if(ids.size()>0) {
-      id=ids.first();
+  struct stat st;
+
+  d_file=file;
+  d_mem=NULL;
+  d_size=d_file->size();
+  d_mtime=0;
+  d_ctime=0;
+  StatFile(d_file->fileName(),&d_source);
+  if((d_size>0)&&(fstat(d_file->handle(),&st)==0)) {
+    d_size=st.st_size;
+    d_mtime=(qint64)st.st_mtim.tv_sec*1000000000+st.st_mtim.tv_nsec;
+    d_ctime=(qint64)st.st_ctim.tv_sec*1000000000+st.st_ctim.tv_nsec;
+    d_mem=d_file->map(0,d_size);
+  }
+  if(d_mem==NULL) {
+    d_bytes=d_file->readAll();
+    d_size=d_bytes.size();
+    delete d_file;
+    d_file=NULL;
+  }
+}
+
+
+Profile::LazyBuffer::~LazyBuffer()
+{
+  if(d_file!=NULL) {
+    d_file->unmap(d_mem);
+    delete d_file;
+  }
+}
+
+
+const char *Profile::LazyBuffer::data() const
+{
+  if(d_file!=NULL) {
+    return (const char *)d_mem;
+  }
+  return d_bytes.constData();
+}
+
+
+qint64 Profile::LazyBuffer::size() const
+{
+  return d_size;
+}
+
+
+const Profile::SourceFile &Profile::LazyBuffer::source() const
+{
+  return d_source;
+}
+
+
+//
+// A mapped file that has been truncated or rewritten since it was scanned
+// can no longer be trusted to match the ranges taken from it, and reading
+// past its new end would fault. Any write to the file moves its change
+// time. A file replaced by renaming another over its path is not affected,
+// as the mapping still holds the original. Copies made with readAll() are
+// always current.
+//
+bool Profile::LazyBuffer::isCurrent() const
+{
+  struct stat st;
+
+  if(d_file==NULL) {
+    return true;
+  }
+  if(fstat(d_file->handle(),&st)!=0) {
+    return false;
+  }
+
+  return (st.st_size==d_size)&&
+    (((qint64)st.st_mtim.tv_sec*1000000000+st.st_mtim.tv_nsec)==d_mtime)&&
+    (((qint64)st.st_ctim.tv_sec*1000000000+st.st_ctim.tv_nsec)==d_ctime);
+}
+
+
+//
+// What the file holds now. This reads through the descriptor, without
+// moving it, so buffers shared between copies of a Profile are safe to
+// read from concurrently.
+//
+QByteArray Profile::LazyBuffer::currentData() const
+{
+  struct stat st;
+  QByteArray ret;
+
+  if(d_file==NULL) {
+    return d_bytes;
+  }
+  if(fstat(d_file->handle(),&st)==0) {
+    ret.resize(st.st_size);
+    ssize_t n=pread(d_file->handle(),ret.data(),ret.size(),0);
+    ret.resize(qMax((ssize_t)0,n));
+  }
+
+  return ret;
+}
+
+
+qint64 Profile::LazyBuffer::heapBytes() const
+{
+  //
+  // A mapped file lives in the page cache, not on the heap
+  //
+  if(d_file!=NULL) {
+    return 0;
+  }
+  return PROFILESTATS_ARRAY_HEADER_BYTES+d_bytes.capacity();
+}
+
+
+bool Profile::LazyReadFile(const QString &filename,QString *err_msg,
+			   SourceFile *src)
+{
+  QFile *file=new QFile(filename);
+  if(!file->open(QFile::ReadOnly)) {
+    delete file;
+    StatFile(filename,src);
+    if(err_msg!=NULL) {
+      *err_msg="unable to open file";
+    }
+    return false;
+  }
+  QSharedPointer<LazyBuffer> buffer(new LazyBuffer(file));
+  *src=buffer->source();
+  if(__Profile_IsWideText(buffer->data(),buffer->size())) {
+    BlockList blocks;
+    ParseBuffer(buffer->data(),buffer->size(),&blocks);
+    ProcessBlocks(blocks);
+  }
+  else {
+    ScanBuffer(buffer);
+  }
+
+  return true;
+}
+
+
+//
+// The lazy scan keeps the file mapped and records only where each block
+// starts and ends. Section names, IDs and tag names are interned as they
+// are found, so that sections() and sectionIds() can be answered straight
+// away and materializing a block later never has to touch the symbol
+// table; values are left alone until the block is first looked up.
+//
+void Profile::ScanBuffer(const QSharedPointer<LazyBuffer> &buffer)
+{
+  const char *data=buffer->data();
+  QHash<QByteArray,int> tags;
+  ProfileScanner scanner(data,buffer->size());
+  LazyRange range;
+  QString block_name;
+  QString block_id;
+  bool has_values=false;
+  bool has_id=false;
+
+  range.buffer=buffer;
+  range.start=-1;
+  range.end=-1;
+  while(true) {
+    bool more=scanner.nextLine();
+    if((!more)||(scanner.lineType()==ProfileScanner::Section)) {
+      if((!block_name.isEmpty())&&has_values) {
+	int id=-1;
+	if(d_use_section_ids) {
+	  id=d_symbols.intern(has_id?block_id:
+			      QString(__PROFILE_DEFAULT_SECTION_ID));
+	}
+	range.end=more?(scanner.lineStart()-data):buffer->size();
+	AddLazyRange(__Profile_BlockKey(d_symbols.intern(block_name),id),
+		     range);
+      }
+      if(!more) {
+	break;
+      }
+      block_name=
+	QString::fromUtf8(scanner.lineStart()+1,scanner.lineLength()-2);
+      range.start=scanner.lineStart()-data;
+      has_values=false;
+      has_id=false;
+      continue;
+    }
+    if((scanner.lineType()!=ProfileScanner::Value)||block_name.isEmpty()) {
+      continue;
     }
-    block_name=name+__PROFILE_SECTION_ID_DELIMITER+id;
+    has_values=true;
+    const char *tag_end=
+      (scanner.separator()==NULL)?scanner.lineEnd():scanner.separator();
+    QByteArray tag=QByteArray::fromRawData(scanner.lineStart(),
+					   tag_end-scanner.lineStart());
+    if(!tags.contains(tag)) {
+      tags[QByteArray(tag.constData(),tag.size())]=
+	d_symbols.intern(QString::fromUtf8(tag.constData(),tag.size()));
+    }
+    if(d_use_section_ids&&(!has_id)&&(tag=="Id")) {
+      if(scanner.separator()!=NULL) {
+	block_id=QString::fromUtf8(scanner.separator()+1,
+			      scanner.lineEnd()-scanner.separator()-1);
+      }
+      else {
+	block_id="";
+      }
+      has_id=true;
+    }
+  }
+  d_generation=__Profile_NextGeneration();
+}
+
+
+void Profile::AddLazyRange(quint64 key,const LazyRange &range)
+{
+  if(!d_blocks.contains(key)) {
+    d_blocks.insert(key,Block());
+    IndexBlock(key);
   }
+  LazyBlock &lazy=d_lazy_blocks[key];
+  if(lazy.materialized.loadAcquire()!=0) {
+    lazy.ranges.clear();
+    lazy.materialized.storeRelease(0);
+  }
+  lazy.ranges.push_back(range);
+}
 
-  if(!lines.isEmpty()) {
-    QMap<QString,QStringList> block=
-      d_blocks.value(block_name,QMap<QString,QStringList>());
 
-    for(QMap<QString,QStringList>::const_iterator it=lines.begin();
-	it!=lines.end();it++) {
-      block[it.key()].append(it.value());
+//
+// Materializing is the only thing a const lookup ever changes. The block
+// itself was created by the scan and its tags already interned, so all
+// that happens here is filling in one Block's values, under a lock and
+// published through the 'materialized' flag. Lookups of other blocks are
+// unaffected. Ranges from a file that has changed on disk since it was
+// scanned are dropped rather than parsed; the next reload picks up the
+// new contents.
+//
+void Profile::Materialize(quint64 key) const
+{
+  QHash<quint64,LazyBlock>::const_iterator it=d_lazy_blocks.constFind(key);
+  if((it==d_lazy_blocks.constEnd())||
+     (it.value().materialized.loadAcquire()!=0)) {
+    return;
+  }
+  QMutexLocker locker(&d_lazy_mutex);
+  if(it.value().materialized.loadAcquire()!=0) {
+    return;
+  }
+  Block &block=const_cast<Block &>(d_blocks.constFind(key).value());
+  QList<const LazyBuffer *> changed;
+  for(int i=0;i<it.value().ranges.size();i++) {
+    const LazyRange &range=it.value().ranges.at(i);
+    if(!range.buffer->isCurrent()) {
+      if(!changed.contains(range.buffer.data())) {
+	changed.push_back(range.buffer.data());
+	MaterializeChanged(key,range.buffer.data(),&block);
+      }
+      continue;
+    }
+    BlockList blocks;
+    ParseChunk(range.buffer->data()+range.start,range.end-range.start,
+	       &blocks);
+    for(int j=0;j<blocks.size();j++) {
+      const QMap<QString,ProfileValues> &lines=blocks.at(j).second;
+      for(QMap<QString,ProfileValues>::const_iterator it1=lines.constBegin();
+	  it1!=lines.constEnd();it1++) {
+	block[d_symbols.symbol(it1.key())].append(it1.value());
+      }
     }
+  }
+  it.value().materialized.storeRelease(1);
+}
+
+
+//
+// The ranges taken from a file that has changed since it was scanned no
+// longer mean anything, so the section is parsed out of what the file
+// holds now instead, and the change is recorded in lazyLoadErrors().
+// Tags that were not in the file when it was scanned are not picked up.
+//
+void Profile::MaterializeChanged(quint64 key,const LazyBuffer *buffer,
+				 Block *block) const
+{
+  QByteArray data=buffer->currentData();
+  BlockList blocks;
+
+  ParseBuffer(data.constData(),data.size(),&blocks);
+  for(int i=0;i<blocks.size();i++) {
+    const QMap<QString,ProfileValues> &lines=blocks.at(i).second;
+    int id=-1;
     if(d_use_section_ids) {
-      d_blocks[block_name]=block;
+      QMap<QString,ProfileValues>::const_iterator it=lines.constFind("Id");
+      if((it!=lines.constEnd())&&(it.value().size()>0)) {
+	id=d_symbols.symbol(it.value().value(0));
+      }
+      else {
+	id=d_symbols.symbol(__PROFILE_DEFAULT_SECTION_ID);
+      }
+      if(id<0) {
+	continue;
+      }
     }
-    else {
-      d_blocks[name]=block;
+    int sect=d_symbols.symbol(blocks.at(i).first);
+    if((sect<0)||(__Profile_BlockKey(sect,id)!=key)) {
+      continue;
+    }
+    for(QMap<QString,ProfileValues>::const_iterator it=lines.constBegin();
+	it!=lines.constEnd();it++) {
+      int tag=d_symbols.symbol(it.key());
+      if(tag>=0) {
+	(*block)[tag].append(it.value());
+      }
     }
   }
+  d_lazy_errors.
+    push_back(QString::asprintf("file \"%s\" changed after it was loaded, "
+				"section \"%s\" read from its current contents",
+				buffer->source().path.toUtf8().constData(),
+				BlockName(key).toUtf8().constData()));
+}
+
+
+void Profile::MaterializeAll() const
+{
+  for(QHash<quint64,LazyBlock>::const_iterator it=d_lazy_blocks.constBegin();
+      it!=d_lazy_blocks.constEnd();it++) {
+    Materialize(it.key());
+  }
 }
 
 
@@ -24,77 +24,362 @@
 #ifndef PROFILE_H
 #define PROFILE_H
 
+#include <stdio.h>
+
+#include <QAtomicInt>
+#include <QAtomicInteger>
+#include <QHash>
 #include <QHostAddress>
+#include <QIODevice>
 #include <QList>
 #include <QMultiMap>
+#include <QMutex>
+#include <QPair>
+#include <QSet>
+#include <QSharedPointer>
 #include <QString>
 #include <QStringList>
+#include <QStringView>
 #include <QTime>
 
+#include "profilestats.h"
+#include "profilesymbols.h"
+#include "profilevalues.h"
+
+class QFile;
+
 class Profile
 {
  public:
+  class Key
+  {
+   public:
+    Key();
+    Key(const QString &section,const QString &tag);
+    Key(const QString &section,const QString &section_id,const QString &tag);
+    QString section() const;
+    QString sectionId() const;
+    QString tag() const;
+
+   private:
+    QString d_section;
+    QString d_section_id;
+    QString d_tag;
+    bool d_use_section_id;
+    mutable const Profile *d_profile;
+    mutable quint64 d_generation;
+    mutable const ProfileValues *d_values;
+    mutable int d_layer;
+    friend class Profile;
+  };
   Profile(bool use_section_ids=false);
+  Profile(const Profile &other);
+  ~Profile();
+  Profile &operator=(const Profile &other);
   QStringList sectionNames() const;
   QString source() const;
+  bool concurrentLoad() const;
+  void setConcurrentLoad(bool state);
+  bool lazyLoad() const;
+  void setLazyLoad(bool state);
+  QStringList lazyLoadErrors() const;
+  bool statsEnabled() const;
+  void setStatsEnabled(bool state);
+  ProfileStats stats() const;
+  void resetStats();
+  QSharedPointer<const Profile> baseLayer() const;
+  bool setBaseLayer(const QSharedPointer<const Profile> &base);
+  int layerCount() const;
   bool addSource(const QStringList &values);
+  bool addSource(QStringList &&values);
+  bool loadData(const char *data,qint64 len,QString *err_msg=NULL);
+  bool loadData(const QByteArray &data,QString *err_msg=NULL);
+  bool loadDevice(QIODevice *dev,QString *err_msg=NULL);
   bool loadFile(const QString &filename,QString *err_msg=NULL);
   int loadDirectory(const QString &dirpath,const QString &glob_template,
 		    QStringList *err_msgs);
   int load(const QString &glob_path,QStringList *err_msgs);
+  static qint64 fileCacheLimit();
+  static void setFileCacheLimit(qint64 bytes);
+  static void clearFileCache();
+  bool saveCompiled(const QString &filename,QString *err_msg=NULL) const;
+  bool loadCompiled(const QString &filename,QString *err_msg=NULL);
   QStringList sections() const;
   QStringList sectionIds(const QString &section) const;
   QString stringValue(const QString &section,const QString &tag,
-		      const QString &default_value="",bool *found=0);
-  QStringList stringValues(const QString &section,const QString &tag);
+		      const QString &default_value="",bool *found=0) const;
+  QStringList stringValues(const QString &section,const QString &tag) const;
   QStringList stringValues(const QString &section,const QString &section_id,
 			   const QString &tag) const;
   int intValue(const QString &section,const QString &tag,
-	       int default_value=0,bool *found=0);
-  QList<int> intValues(const QString &section,const QString &tag);
+	       int default_value=0,bool *found=0) const;
+  QList<int> intValues(const QString &section,const QString &tag) const;
   QList<int> intValues(const QString &section,const QString &section_id,
-		       const QString &tag);
+		       const QString &tag) const;
   int hexValue(const QString &section,const QString &tag,
-	       int default_value=0,bool *found=0);
-  QList<int> hexValues(const QString &section,const QString &tag);
+	       int default_value=0,bool *found=0) const;
+  QList<int> hexValues(const QString &section,const QString &tag) const;
   QList<int> hexValues(const QString &section,const QString &section_id,
-		       const QString &tag);
+		       const QString &tag) const;
   double doubleValue(const QString &section,const QString &tag,
-		    double default_value=0.0,bool *found=0);
-  QList<double> doubleValues(const QString &section,const QString &tag);
+		    double default_value=0.0,bool *found=0) const;
+  QList<double> doubleValues(const QString &section,const QString &tag) const;
   QList<double> doubleValues(const QString &section,const QString &section_id,
-			     const QString &tag);
+			     const QString &tag) const;
   bool boolValue(const QString &section,const QString &tag,
-		 bool default_value=false,bool *found=0);
-  QList<bool> boolValues(const QString &section,const QString &tag);
+		 bool default_value=false,bool *found=0) const;
+  QList<bool> boolValues(const QString &section,const QString &tag) const;
   QList<bool> boolValues(const QString &section,const QString &section_id,
-			 const QString &tag);
+			 const QString &tag) const;
   QTime timeValue(const QString &section,const QString &tag,
-		  const QTime &default_value=QTime(),bool *found=0);
-  QList<QTime> timeValues(const QString &section,const QString &tag);
+		  const QTime &default_value=QTime(),bool *found=0) const;
+  QList<QTime> timeValues(const QString &section,const QString &tag) const;
   QList<QTime> timeValues(const QString &section,const QString &section_id,
-			  const QString &tag);
+			  const QString &tag) const;
   QHostAddress addressValue(const QString &section,const QString &tag,
 			    const QHostAddress &default_value=QHostAddress(),
-			    bool *found=0);
+			    bool *found=0) const;
   QHostAddress addressValue(const QString &section,const QString &tag,
-			    const QString &default_value="",bool *found=0);
-  QList<QHostAddress> addressValues(const QString &section,const QString &tag);
+			    const QString &default_value="",
+			    bool *found=0) const;
+  QList<QHostAddress> addressValues(const QString &section,
+				    const QString &tag) const;
   QList<QHostAddress> addressValues(const QString &section,
 				    const QString &section_id,
-				    const QString &tag);
+				    const QString &tag) const;
+  //
+  // The references returned by stringValuesRef() and the views returned
+  // by valueAt() point into the Profile itself. They stay valid while
+  // more data is loaded, but not once the section they came from is
+  // reloaded or the Profile is cleared or destroyed.
+  //
+  const QStringList &stringValuesRef(const QString &section,
+				     const QString &tag) const;
+  const QStringList &stringValuesRef(const QString &section,
+				     const QString &section_id,
+				     const QString &tag) const;
+  int valueCount(const QString &section,const QString &tag) const;
+  int valueCount(const QString &section,const QString &section_id,
+		 const QString &tag) const;
+  QStringView valueAt(const QString &section,const QString &tag,int n) const;
+  QStringView valueAt(const QString &section,const QString &section_id,
+		      const QString &tag,int n) const;
+  int readIntValues(const QString &section,const QString &tag,int *values,
+		    int max,QList<int> *errors=NULL) const;
+  int readIntValues(const QString &section,const QString &section_id,
+		    const QString &tag,int *values,int max,
+		    QList<int> *errors=NULL) const;
+  int readHexValues(const QString &section,const QString &tag,int *values,
+		    int max,QList<int> *errors=NULL) const;
+  int readHexValues(const QString &section,const QString &section_id,
+		    const QString &tag,int *values,int max,
+		    QList<int> *errors=NULL) const;
+  int readDoubleValues(const QString &section,const QString &tag,
+		       double *values,int max,QList<int> *errors=NULL) const;
+  int readDoubleValues(const QString &section,const QString &section_id,
+		       const QString &tag,double *values,int max,
+		       QList<int> *errors=NULL) const;
+
+  QString stringValue(const Key &key,const QString &default_value="",
+		      bool *found=0) const;
+  QStringList stringValues(const Key &key) const;
+  const QStringList &stringValuesRef(const Key &key) const;
+  int valueCount(const Key &key) const;
+  QStringView valueAt(const Key &key,int n) const;
+  int readIntValues(const Key &key,int *values,int max,
+		    QList<int> *errors=NULL) const;
+  int readHexValues(const Key &key,int *values,int max,
+		    QList<int> *errors=NULL) const;
+  int readDoubleValues(const Key &key,double *values,int max,
+		       QList<int> *errors=NULL) const;
+  int intValue(const Key &key,int default_value=0,bool *found=0) const;
+  QList<int> intValues(const Key &key) const;
+  int hexValue(const Key &key,int default_value=0,bool *found=0) const;
+  QList<int> hexValues(const Key &key) const;
+  double doubleValue(const Key &key,double default_value=0.0,
+		     bool *found=0) const;
+  QList<double> doubleValues(const Key &key) const;
+  bool boolValue(const Key &key,bool default_value=false,bool *found=0) const;
+  QList<bool> boolValues(const Key &key) const;
+  QTime timeValue(const Key &key,const QTime &default_value=QTime(),
+		  bool *found=0) const;
+  QList<QTime> timeValues(const Key &key) const;
+  QHostAddress addressValue(const Key &key,
+			    const QHostAddress &default_value=QHostAddress(),
+			    bool *found=0) const;
+  QList<QHostAddress> addressValues(const Key &key) const;
 
   void clear();
   QString dump() const;
+  bool dump(QIODevice *dev) const;
+  bool dump(FILE *f) const;
 
  private:
+  void CopyFrom(const Profile &other);
+  void AddSourceLines(QStringList *lines,bool consume);
   void ProcessBlock(const QString &name,
-		    const QMap<QString,QStringList> &lines);
+		    const QMap<QString,ProfileValues> &lines);
+  typedef QList<QPair<QString,QMap<QString,ProfileValues> > > BlockList;
+  void ProcessBlocks(const BlockList &blocks);
+  void RebuildSections(const QList<const BlockList *> &sources,
+		       const QSet<QString> &sections);
+  void IndexBlock(quint64 key);
+  void UnindexSection(int section);
+  void RebuildIndex();
+  struct SourceFile
+  {
+    QString path;
+    qint64 size;
+    qint64 mtime;
+  };
+  struct Source
+  {
+    QString path;
+    QString glob_template;
+    QList<SourceFile> files;
+  };
+  static bool ListDirectory(const QString &dirpath,
+			    const QString &glob_template,QString *path,
+			    QStringList *filenames,QStringList *err_msgs);
+  static QString LoadMessage(const QString &path,const QString &filename,
+			     bool loaded,const QString &err_msg);
+  static bool ReadFile(const QString &filename,BlockList *blocks,
+		       QString *err_msg,SourceFile *src=NULL,
+		       bool *cached=NULL);
+  struct CachedFile
+  {
+    quint64 device;
+    quint64 inode;
+    qint64 size;
+    qint64 mtime;
+    quint64 used;
+    qint64 bytes;
+    BlockList blocks;
+  };
+  struct FileCacheData
+  {
+    QHash<QString,CachedFile> files;
+    qint64 bytes;
+    quint64 uses;
+  };
+  static QMutex *FileCacheMutex();
+  static FileCacheData *FileCache();
+  static bool IdentifyFile(QFile *file,CachedFile *entry);
+  static bool FindCachedFile(const QString &filename,const CachedFile &entry,
+			     BlockList *blocks);
+  static void AddCachedFile(const QString &filename,const CachedFile &entry);
+  static void TrimFileCache(FileCacheData *cache);
+  static qint64 BlockListBytes(const BlockList &blocks);
+  static void StatFile(const QString &filename,SourceFile *src);
+  static bool SourcesCurrent(const QList<Source> &sources);
+  void SetSource(const QString &path,const QString &glob_template,
+		 const QList<SourceFile> &files);
+  bool ReadCompiled(const QByteArray &data,QString *err_msg);
+  static void ParseBuffer(const char *data,qint64 len,BlockList *blocks);
+  static void ParseChunk(const char *data,qint64 len,BlockList *blocks);
+  static QList<qint64> ChunkOffsets(const char *data,qint64 len);
+  class LazyBuffer
+  {
+   public:
+    LazyBuffer(QFile *file);
+    ~LazyBuffer();
+    const char *data() const;
+    qint64 size() const;
+    qint64 heapBytes() const;
+    const SourceFile &source() const;
+    bool isCurrent() const;
+    QByteArray currentData() const;
+
+   private:
+    QFile *d_file;
+    uchar *d_mem;
+    qint64 d_size;
+    qint64 d_mtime;
+    qint64 d_ctime;
+    QByteArray d_bytes;
+    SourceFile d_source;
+  };
+  struct LazyRange
+  {
+    QSharedPointer<LazyBuffer> buffer;
+    qint64 start;
+    qint64 end;
+  };
+  struct LazyBlock
+  {
+    QList<LazyRange> ranges;
+    mutable QAtomicInt materialized;
+  };
+  bool LazyReadFile(const QString &filename,QString *err_msg,
+		    SourceFile *src);
+  void ScanBuffer(const QSharedPointer<LazyBuffer> &buffer);
+  void AddLazyRange(quint64 key,const LazyRange &range);
+  void Materialize(quint64 key) const;
+  void MaterializeAll() const;
+  const ProfileValues *FindValues(const QString &section,
+				  const QString &tag) const;
+  const ProfileValues *FindValues(const QString &section,
+				  const QString &section_id,
+				  const QString &tag) const;
+  const ProfileValues *FindValues(int section,int id,int tag) const;
+  const ProfileValues *FindValues(const Key &key) const;
+  const ProfileValues *FindLayerValues(const QString &section,
+				       const QString &section_id,
+				       const QString &tag,bool use_section_id,
+				       int *layer) const;
+  void CountLayer(int layer) const;
+  quint64 LayerGeneration() const;
+  Profile *Flattened() const;
+  const ProfileValues *Counted(ProfileStats::Type type,
+			       const ProfileValues *values) const;
+  void AddFileStats(const QString &path,qint64 bytes,qint64 nsecs,
+		    bool cached=false);
+  typedef QHash<int,ProfileValues> Block;
+  void MaterializeChanged(quint64 key,const LazyBuffer *buffer,
+			  Block *block) const;
+  const Block *FindBlock(const QString &section,
+			 const QString &section_id) const;
+  const ProfileValues *FindValues(const Block *block,const QString &tag) const;
+  static const QStringList &EmptyValues();
+  QString BlockName(quint64 key) const;
+  QStringList BlockHeader(quint64 key) const;
+  QList<quint64> SortedBlockKeys() const;
+  QMap<QString,QPair<QString,QString> >
+    LayeredBlockNames(const QString &section=QString()) const;
   QStringList InvertList(const QStringList &list) const;
   void DumpList(const QString &title,const QStringList &list) const;
+  bool WriteDump(QIODevice *dev,FILE *f) const;
   QString profile_source;
-  QMap<QString,QMap<QString,QStringList> > d_blocks;
+  QHash<quint64,Block> d_blocks;
+  struct SectionIndex
+  {
+    QString order_key;
+    QMap<QString,int> ids;
+  };
+  QHash<int,SectionIndex> d_section_index;
+  QMultiMap<QString,int> d_section_order;
+  ProfileSymbols d_symbols;
+  QList<Source> d_sources;
+  QSharedPointer<const Profile> d_base;
+  bool d_unkeyed_source;
+  quint64 d_generation;
   bool d_use_section_ids;
+  bool d_concurrent_load;
+  bool d_lazy_load;
+  QHash<quint64,LazyBlock> d_lazy_blocks;
+  mutable QMutex d_lazy_mutex;
+  mutable QStringList d_lazy_errors;
+  struct StatsCounters
+  {
+    QList<ProfileStats::File> files;
+    QAtomicInteger<quint64> hits[ProfileStats::LastType];
+    QAtomicInteger<quint64> misses[ProfileStats::LastType];
+    QAtomicInteger<quint64> layer_hits[PROFILESTATS_MAX_LAYERS];
+  };
+  StatsCounters *d_stats;
+  friend class ProfileBindingBase;
+  friend class ProfileDiff;
+  friend class ProfileWatcher;
 };
 
 
@@ -0,0 +1,294 @@
+// profilebinding.cpp
+//
+// Bind the fields of a C++ struct to Profile tags.
+//
+// (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of version 2.1 of the GNU Lesser General Public
+//    License as published by the Free Software Foundation;
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330,
+//    Boston, MA  02111-1307  USA
+//
+// EXEMPLAR_VERSION: 2.0.2
+//
+
+#include "profilebinding.h"
+
+ProfileBindingBase::Field::Field(const QString &tag,ProfileStats::Type type)
+{
+  d_tag=tag;
+  d_type=type;
+}
+
+
+ProfileBindingBase::Field::~Field()
+{
+}
+
+
+const QString &ProfileBindingBase::Field::tag() const
+{
+  return d_tag;
+}
+
+
+ProfileStats::Type ProfileBindingBase::Field::type() const
+{
+  return d_type;
+}
+
+
+ProfileBindingBase::ProfileBindingBase()
+{
+  d_field_count=0;
+}
+
+
+int ProfileBindingBase::fieldCount() const
+{
+  return d_field_count;
+}
+
+
+void ProfileBindingBase::AddField(const QString &section,
+				  const QString &section_id,Field *field)
+{
+  for(int i=0;i<d_sections.size();i++) {
+    if((d_sections.at(i).section==section)&&
+       (d_sections.at(i).section_id==section_id)) {
+      d_sections[i].fields.push_back(QSharedPointer<Field>(field));
+      d_field_count++;
+      return;
+    }
+  }
+  Section sect;
+  sect.section=section;
+  sect.section_id=section_id;
+  sect.fields.push_back(QSharedPointer<Field>(field));
+  d_sections.push_back(sect);
+  d_field_count++;
+}
+
+
+bool ProfileBindingBase::Read(const Profile *p,void *obj,
+			      QStringList *missing) const
+{
+  bool ret=true;
+
+  for(int i=0;i<d_sections.size();i++) {
+    const Section &sect=d_sections.at(i);
+    QList<QPair<const Profile *,const Profile::Block *> > blocks;
+    QList<int> layers;
+    int layer_num=0;
+    for(const Profile *layer=p;layer!=NULL;layer=layer->d_base.data()) {
+      const Profile::Block *block=
+	layer->FindBlock(sect.section,sect.section_id);
+      if(block!=NULL) {
+	blocks.push_back(qMakePair(layer,block));
+	layers.push_back(layer_num);
+      }
+      layer_num++;
+    }
+    for(int j=0;j<sect.fields.size();j++) {
+      const Field *field=sect.fields.at(j).data();
+      const ProfileValues *values=NULL;
+      int k=0;
+      for(k=0;(values==NULL)&&(k<blocks.size());k++) {
+	values=blocks.at(k).first->FindValues(blocks.at(k).second,
+					      field->tag());
+      }
+      if(values!=NULL) {
+	p->CountLayer(layers.at(k-1));
+      }
+      p->Counted(field->type(),values);
+      if(values==NULL) {
+	ret=false;
+	if(missing!=NULL) {
+	  if(sect.section_id.isNull()) {
+	    missing->push_back(sect.section+"/"+field->tag());
+	  }
+	  else {
+	    missing->push_back(sect.section+"|"+sect.section_id+"/"+
+			       field->tag());
+	  }
+	}
+      }
+      field->assign(obj,values);
+    }
+  }
+
+  return ret;
+}
+
+
+void ProfileBindingBase::Convert(const ProfileValues *values,QString *value)
+{
+  *value=values->value(0);
+}
+
+
+void ProfileBindingBase::Convert(const ProfileValues *values,
+				 QStringList *value)
+{
+  *value=values->toStrings();
+}
+
+
+void ProfileBindingBase::Convert(const ProfileValues *values,int *value)
+{
+  *value=values->intValues().first();
+}
+
+
+void ProfileBindingBase::Convert(const ProfileValues *values,
+				 QList<int> *value)
+{
+  *value=values->intValues();
+}
+
+
+void ProfileBindingBase::Convert(const ProfileValues *values,double *value)
+{
+  *value=values->doubleValues().first();
+}
+
+
+void ProfileBindingBase::Convert(const ProfileValues *values,
+				 QList<double> *value)
+{
+  *value=values->doubleValues();
+}
+
+
+void ProfileBindingBase::Convert(const ProfileValues *values,bool *value)
+{
+  *value=values->boolValues().first();
+}
+
+
+void ProfileBindingBase::Convert(const ProfileValues *values,
+				 QList<bool> *value)
+{
+  *value=values->boolValues();
+}
+
+
+void ProfileBindingBase::Convert(const ProfileValues *values,QTime *value)
+{
+  *value=values->timeValues().first();
+}
+
+
+void ProfileBindingBase::Convert(const ProfileValues *values,
+				 QList<QTime> *value)
+{
+  *value=values->timeValues();
+}
+
+
+void ProfileBindingBase::Convert(const ProfileValues *values,
+				 QHostAddress *value)
+{
+  *value=values->addressValues().first();
+}
+
+
+void ProfileBindingBase::Convert(const ProfileValues *values,
+				 QList<QHostAddress> *value)
+{
+  *value=values->addressValues();
+}
+
+
+void ProfileBindingBase::ConvertHex(const ProfileValues *values,int *value)
+{
+  *value=values->hexValues().first();
+}
+
+
+void ProfileBindingBase::ConvertHex(const ProfileValues *values,
+				    QList<int> *value)
+{
+  *value=values->hexValues();
+}
+
+
+ProfileStats::Type ProfileBindingBase::TypeOf(const QString *)
+{
+  return ProfileStats::String;
+}
+
+
+ProfileStats::Type ProfileBindingBase::TypeOf(const QStringList *)
+{
+  return ProfileStats::String;
+}
+
+
+ProfileStats::Type ProfileBindingBase::TypeOf(const int *)
+{
+  return ProfileStats::Int;
+}
+
+
+ProfileStats::Type ProfileBindingBase::TypeOf(const QList<int> *)
+{
+  return ProfileStats::Int;
+}
+
+
+ProfileStats::Type ProfileBindingBase::TypeOf(const double *)
+{
+  return ProfileStats::Double;
+}
+
+
+ProfileStats::Type ProfileBindingBase::TypeOf(const QList<double> *)
+{
+  return ProfileStats::Double;
+}
+
+
+ProfileStats::Type ProfileBindingBase::TypeOf(const bool *)
+{
+  return ProfileStats::Bool;
+}
+
+
+ProfileStats::Type ProfileBindingBase::TypeOf(const QList<bool> *)
+{
+  return ProfileStats::Bool;
+}
+
+
+ProfileStats::Type ProfileBindingBase::TypeOf(const QTime *)
+{
+  return ProfileStats::Time;
+}
+
+
+ProfileStats::Type ProfileBindingBase::TypeOf(const QList<QTime> *)
+{
+  return ProfileStats::Time;
+}
+
+
+ProfileStats::Type ProfileBindingBase::TypeOf(const QHostAddress *)
+{
+  return ProfileStats::Address;
+}
+
+
+ProfileStats::Type ProfileBindingBase::TypeOf(const QList<QHostAddress> *)
+{
+  return ProfileStats::Address;
+}
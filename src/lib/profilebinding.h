@@ -0,0 +1,190 @@
+// profilebinding.h
+//
+// Bind the fields of a C++ struct to Profile tags.
+//
+// (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of version 2.1 of the GNU Lesser General Public
+//    License as published by the Free Software Foundation;
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330,
+//    Boston, MA  02111-1307  USA
+//
+// EXEMPLAR_VERSION: 2.0.2
+//
+
+#ifndef PROFILEBINDING_H
+#define PROFILEBINDING_H
+
+#include <QHostAddress>
+#include <QList>
+#include <QSharedPointer>
+#include <QString>
+#include <QStringList>
+#include <QTime>
+
+#include "profile.h"
+
+class ProfileBindingBase
+{
+ public:
+  ProfileBindingBase();
+  int fieldCount() const;
+
+ protected:
+  template<class T>
+  struct Value
+  {
+    typedef T Type;  // Keeps defaults from taking part in type deduction
+  };
+  class Field
+  {
+   public:
+    Field(const QString &tag,ProfileStats::Type type);
+    virtual ~Field();
+    const QString &tag() const;
+    ProfileStats::Type type() const;
+    virtual void assign(void *obj,const ProfileValues *values) const=0;
+
+   private:
+    QString d_tag;
+    ProfileStats::Type d_type;
+  };
+  void AddField(const QString &section,const QString &section_id,
+		Field *field);
+  bool Read(const Profile *p,void *obj,QStringList *missing) const;
+  static void Convert(const ProfileValues *values,QString *value);
+  static void Convert(const ProfileValues *values,QStringList *value);
+  static void Convert(const ProfileValues *values,int *value);
+  static void Convert(const ProfileValues *values,QList<int> *value);
+  static void Convert(const ProfileValues *values,double *value);
+  static void Convert(const ProfileValues *values,QList<double> *value);
+  static void Convert(const ProfileValues *values,bool *value);
+  static void Convert(const ProfileValues *values,QList<bool> *value);
+  static void Convert(const ProfileValues *values,QTime *value);
+  static void Convert(const ProfileValues *values,QList<QTime> *value);
+  static void Convert(const ProfileValues *values,QHostAddress *value);
+  static void Convert(const ProfileValues *values,
+		      QList<QHostAddress> *value);
+  static void ConvertHex(const ProfileValues *values,int *value);
+  static void ConvertHex(const ProfileValues *values,QList<int> *value);
+  static ProfileStats::Type TypeOf(const QString *value);
+  static ProfileStats::Type TypeOf(const QStringList *value);
+  static ProfileStats::Type TypeOf(const int *value);
+  static ProfileStats::Type TypeOf(const QList<int> *value);
+  static ProfileStats::Type TypeOf(const double *value);
+  static ProfileStats::Type TypeOf(const QList<double> *value);
+  static ProfileStats::Type TypeOf(const bool *value);
+  static ProfileStats::Type TypeOf(const QList<bool> *value);
+  static ProfileStats::Type TypeOf(const QTime *value);
+  static ProfileStats::Type TypeOf(const QList<QTime> *value);
+  static ProfileStats::Type TypeOf(const QHostAddress *value);
+  static ProfileStats::Type TypeOf(const QList<QHostAddress> *value);
+
+ private:
+  struct Section
+  {
+    QString section;
+    QString section_id;
+    QList<QSharedPointer<Field> > fields;
+  };
+  QList<Section> d_sections;
+  int d_field_count;
+};
+
+
+//
+// The field list is built once, typically into a static, and then used to
+// fill any number of structs. Each field is read through a converter that
+// is chosen by overload resolution when it is bound, and fields are grouped
+// by section so that each section is looked up only once per read(). The
+// list itself is built at run time rather than generated at compile time,
+// so each field costs one virtual call and one call through a converter
+// pointer on top of the lookup.
+//
+template<class S>
+class ProfileBinding : public ProfileBindingBase
+{
+ public:
+  template<class T>
+  ProfileBinding &bind(const QString &section,const QString &tag,
+		       T S::*member,
+		       const typename Value<T>::Type &default_value=T())
+  {
+    return bind(section,QString(),tag,member,default_value);
+  }
+  template<class T>
+  ProfileBinding &bind(const QString &section,const QString &section_id,
+		       const QString &tag,T S::*member,
+		       const typename Value<T>::Type &default_value=T())
+  {
+    void (*convert)(const ProfileValues *,T *)=&ProfileBindingBase::Convert;
+    AddField(section,section_id,
+	     new Member<T>(tag,TypeOf((const T *)NULL),member,default_value,
+			   convert));
+    return *this;
+  }
+  template<class T>
+  ProfileBinding &bindHex(const QString &section,const QString &tag,
+			  T S::*member,
+			  const typename Value<T>::Type &default_value=T())
+  {
+    return bindHex(section,QString(),tag,member,default_value);
+  }
+  template<class T>
+  ProfileBinding &bindHex(const QString &section,const QString &section_id,
+			  const QString &tag,T S::*member,
+			  const typename Value<T>::Type &default_value=T())
+  {
+    void (*convert)(const ProfileValues *,T *)=
+      &ProfileBindingBase::ConvertHex;
+    AddField(section,section_id,
+	     new Member<T>(tag,ProfileStats::Hex,member,default_value,
+			   convert));
+    return *this;
+  }
+  bool read(const Profile *p,S *obj,QStringList *missing=NULL) const
+  {
+    return Read(p,obj,missing);
+  }
+
+ private:
+  template<class T>
+  class Member : public Field
+  {
+   public:
+    Member(const QString &tag,ProfileStats::Type type,T S::*member,
+	   const T &default_value,void (*convert)(const ProfileValues *,T *))
+      : Field(tag,type)
+    {
+      d_member=member;
+      d_default_value=default_value;
+      d_convert=convert;
+    }
+    void assign(void *obj,const ProfileValues *values) const
+    {
+      if(values==NULL) {
+	((S *)obj)->*d_member=d_default_value;
+      }
+      else {
+	d_convert(values,&(((S *)obj)->*d_member));
+      }
+    }
+
+   private:
+    T S::*d_member;
+    T d_default_value;
+    void (*d_convert)(const ProfileValues *,T *);
+  };
+};
+
+
+#endif  // PROFILEBINDING_H
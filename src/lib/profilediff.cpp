@@ -0,0 +1,352 @@
+// profilediff.cpp
+//
+// Structural comparison of two Profiles.
+//
+// (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of version 2.1 of the GNU Lesser General Public
+//    License as published by the Free Software Foundation;
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330,
+//    Boston, MA  02111-1307  USA
+//
+// EXEMPLAR_VERSION: 2.0.2
+//
+
+#include <string.h>
+
+#include "profilediff.h"
+
+static bool __ProfileDiff_SameValue(const ProfileValues &from,int from_n,
+				    const ProfileValues &to,int to_n)
+{
+  int from_len=0;
+  int to_len=0;
+  const char *from_data=from.utf8(from_n,&from_len);
+  const char *to_data=to.utf8(to_n,&to_len);
+
+  return (from_len==to_len)&&(memcmp(from_data,to_data,from_len)==0);
+}
+
+
+static QString __ProfileDiff_RangeText(int start,int count)
+{
+  //
+  // As 'diff -u' does, an empty range gives the line before it
+  //
+  if(count==0) {
+    return QString::asprintf("%d,0",start-1);
+  }
+  if(count==1) {
+    return QString::asprintf("%d",start);
+  }
+  return QString::asprintf("%d,%d",start,count);
+}
+
+
+//
+// Both profiles are walked in dump() order, so the difference between
+// their dumps falls out of a single merge pass over sections, then tags,
+// with no general purpose line matching. Only the lines that end up in a
+// hunk are kept.
+//
+ProfileDiff::ProfileDiff(const Profile *from,const Profile *to,int context)
+{
+  d_context=context;
+  d_from_line=1;
+  d_to_line=1;
+  d_removed_lines=0;
+  d_added_lines=0;
+  d_hunk_open=false;
+
+  Profile *flat_from=NULL;
+  Profile *flat_to=NULL;
+  if(!from->d_base.isNull()) {
+    from=flat_from=from->Flattened();
+  }
+  if(!to->d_base.isNull()) {
+    to=flat_to=to->Flattened();
+  }
+  from->MaterializeAll();
+  to->MaterializeAll();
+  DiffBlocks(from,to);
+  if(d_hunk_open) {
+    CloseHunk(qMin(d_pending.size(),d_context));
+  }
+  d_pending.clear();
+  if(flat_from!=NULL) {
+    delete flat_from;
+  }
+  if(flat_to!=NULL) {
+    delete flat_to;
+  }
+}
+
+
+bool ProfileDiff::isEmpty() const
+{
+  return d_hunks.isEmpty();
+}
+
+
+int ProfileDiff::removedLines() const
+{
+  return d_removed_lines;
+}
+
+
+int ProfileDiff::addedLines() const
+{
+  return d_added_lines;
+}
+
+
+QString ProfileDiff::unified(const QString &from_label,
+			     const QString &to_label) const
+{
+  QString ret;
+
+  if(d_hunks.isEmpty()) {
+    return ret;
+  }
+  ret+="--- "+from_label+"\n";
+  ret+="+++ "+to_label+"\n";
+  for(int i=0;i<d_hunks.size();i++) {
+    const Hunk &hunk=d_hunks.at(i);
+    ret+="@@ -"+__ProfileDiff_RangeText(hunk.from_start,hunk.from_count)+
+      " +"+__ProfileDiff_RangeText(hunk.to_start,hunk.to_count)+" @@\n";
+    for(int j=0;j<hunk.lines.size();j++) {
+      ret+=hunk.lines.at(j)+"\n";
+    }
+  }
+
+  return ret;
+}
+
+
+void ProfileDiff::DiffBlocks(const Profile *from,const Profile *to)
+{
+  QList<quint64> from_keys=from->SortedBlockKeys();
+  QList<quint64> to_keys=to->SortedBlockKeys();
+  int i=0;
+  int j=0;
+
+  while((i<from_keys.size())||(j<to_keys.size())) {
+    if(i==from_keys.size()) {
+      EmitBlock(ProfileDiff::Added,to,to_keys.at(j++));
+      continue;
+    }
+    if(j==to_keys.size()) {
+      EmitBlock(ProfileDiff::Removed,from,from_keys.at(i++));
+      continue;
+    }
+    QString from_name=from->BlockName(from_keys.at(i));
+    QString to_name=to->BlockName(to_keys.at(j));
+    if(from_name<to_name) {
+      EmitBlock(ProfileDiff::Removed,from,from_keys.at(i++));
+    }
+    else {
+      if(to_name<from_name) {
+	EmitBlock(ProfileDiff::Added,to,to_keys.at(j++));
+      }
+      else {
+	DiffBlock(from,from_keys.at(i++),to,to_keys.at(j++));
+      }
+    }
+  }
+}
+
+
+void ProfileDiff::DiffBlock(const Profile *from,quint64 from_key,
+			    const Profile *to,quint64 to_key)
+{
+  QStringList header=from->BlockHeader(from_key);
+  if(header!=to->BlockHeader(to_key)) {
+    EmitBlock(ProfileDiff::Removed,from,from_key);
+    EmitBlock(ProfileDiff::Added,to,to_key);
+    return;
+  }
+  for(int i=0;i<header.size();i++) {
+    Emit(ProfileDiff::Same,header.at(i));
+  }
+
+  const Profile::Block &from_block=from->d_blocks.constFind(from_key).value();
+  const Profile::Block &to_block=to->d_blocks.constFind(to_key).value();
+  QMap<QString,int> from_tags=SortedTags(from,from_block);
+  QMap<QString,int> to_tags=SortedTags(to,to_block);
+  QMap<QString,int>::const_iterator it=from_tags.constBegin();
+  QMap<QString,int>::const_iterator it1=to_tags.constBegin();
+  while((it!=from_tags.constEnd())||(it1!=to_tags.constEnd())) {
+    if((it1==to_tags.constEnd())||
+       ((it!=from_tags.constEnd())&&(it.key()<it1.key()))) {
+      const ProfileValues &values=from_block.constFind(it.value()).value();
+      EmitValues(ProfileDiff::Removed,it.key(),values,0,values.size());
+      it++;
+    }
+    else {
+      if((it==from_tags.constEnd())||(it1.key()<it.key())) {
+	const ProfileValues &values=to_block.constFind(it1.value()).value();
+	EmitValues(ProfileDiff::Added,it1.key(),values,0,values.size());
+	it1++;
+      }
+      else {
+	DiffValues(it.key(),from_block.constFind(it.value()).value(),
+		   to_block.constFind(it1.value()).value());
+	it++;
+	it1++;
+      }
+    }
+  }
+}
+
+
+//
+// Values are matched on their common leading and trailing runs, with
+// whatever is left in between treated as replaced. That keeps the pass
+// linear, at the cost of a less compact diff when values are reordered.
+//
+void ProfileDiff::DiffValues(const QString &tag,const ProfileValues &from,
+			     const ProfileValues &to)
+{
+  int prefix=0;
+  while((prefix<from.size())&&(prefix<to.size())&&
+	__ProfileDiff_SameValue(from,prefix,to,prefix)) {
+    prefix++;
+  }
+  int suffix=0;
+  while(((from.size()-suffix)>prefix)&&((to.size()-suffix)>prefix)&&
+	__ProfileDiff_SameValue(from,from.size()-suffix-1,
+				to,to.size()-suffix-1)) {
+    suffix++;
+  }
+  EmitValues(ProfileDiff::Same,tag,from,0,prefix);
+  EmitValues(ProfileDiff::Removed,tag,from,prefix,from.size()-suffix);
+  EmitValues(ProfileDiff::Added,tag,to,prefix,to.size()-suffix);
+  EmitValues(ProfileDiff::Same,tag,from,from.size()-suffix,from.size());
+}
+
+
+void ProfileDiff::EmitBlock(Op op,const Profile *p,quint64 key)
+{
+  QStringList header=p->BlockHeader(key);
+  for(int i=0;i<header.size();i++) {
+    Emit(op,header.at(i));
+  }
+  const Profile::Block &block=p->d_blocks.constFind(key).value();
+  QMap<QString,int> tags=SortedTags(p,block);
+  for(QMap<QString,int>::const_iterator it=tags.constBegin();
+      it!=tags.constEnd();it++) {
+    const ProfileValues &values=block.constFind(it.value()).value();
+    EmitValues(op,it.key(),values,0,values.size());
+  }
+}
+
+
+void ProfileDiff::EmitValues(Op op,const QString &tag,
+			     const ProfileValues &values,int first,int last)
+{
+  for(int i=first;i<last;i++) {
+    int len=0;
+    const char *data=values.utf8(i,&len);
+    Emit(op,tag+"="+QString::fromUtf8(data,len));
+  }
+}
+
+
+//
+// Unchanged lines are held back until it is known whether they are
+// context for a hunk. Once more than twice the context has gone by
+// since the last change, the open hunk can be closed.
+//
+void ProfileDiff::Emit(Op op,const QString &line)
+{
+  if(op==ProfileDiff::Same) {
+    d_pending.push_back(" "+line);
+    if(d_hunk_open) {
+      if(d_pending.size()>(2*d_context)) {
+	CloseHunk(d_context);
+	while(d_pending.size()>d_context) {
+	  d_pending.removeFirst();
+	}
+      }
+    }
+    else {
+      if(d_pending.size()>d_context) {
+	d_pending.removeFirst();
+      }
+    }
+    d_from_line++;
+    d_to_line++;
+    return;
+  }
+
+  if(!d_hunk_open) {
+    Hunk hunk;
+    hunk.from_start=d_from_line-d_pending.size();
+    hunk.from_count=d_pending.size();
+    hunk.to_start=d_to_line-d_pending.size();
+    hunk.to_count=d_pending.size();
+    hunk.lines=d_pending;
+    d_hunks.push_back(hunk);
+    d_hunk_open=true;
+  }
+  else {
+    Hunk &hunk=d_hunks.last();
+    hunk.from_count+=d_pending.size();
+    hunk.to_count+=d_pending.size();
+    hunk.lines+=d_pending;
+  }
+  d_pending.clear();
+
+  Hunk &hunk=d_hunks.last();
+  if(op==ProfileDiff::Removed) {
+    hunk.lines.push_back("-"+line);
+    hunk.from_count++;
+    d_from_line++;
+    d_removed_lines++;
+  }
+  else {
+    hunk.lines.push_back("+"+line);
+    hunk.to_count++;
+    d_to_line++;
+    d_added_lines++;
+  }
+}
+
+
+void ProfileDiff::CloseHunk(int context_lines)
+{
+  Hunk &hunk=d_hunks.last();
+  for(int i=0;i<context_lines;i++) {
+    hunk.lines.push_back(d_pending.at(i));
+  }
+  hunk.from_count+=context_lines;
+  hunk.to_count+=context_lines;
+  d_hunk_open=false;
+}
+
+
+QMap<QString,int> ProfileDiff::SortedTags(const Profile *p,
+					  const Profile::Block &block)
+{
+  QMap<QString,int> ret;
+
+  for(Profile::Block::const_iterator it=block.constBegin();
+      it!=block.constEnd();it++) {
+    QString tag=p->d_symbols.name(it.key());
+    if(p->d_use_section_ids&&(tag=="Id")) {
+      continue;
+    }
+    ret[tag]=it.key();
+  }
+
+  return ret;
+}
@@ -0,0 +1,79 @@
+// profilediff.h
+//
+// Structural comparison of two Profiles.
+//
+// (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of version 2.1 of the GNU Lesser General Public
+//    License as published by the Free Software Foundation;
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330,
+//    Boston, MA  02111-1307  USA
+//
+// EXEMPLAR_VERSION: 2.0.2
+//
+
+#ifndef PROFILEDIFF_H
+#define PROFILEDIFF_H
+
+#include <QList>
+#include <QMap>
+#include <QString>
+#include <QStringList>
+
+#include "profile.h"
+
+#define PROFILEDIFF_DEFAULT_CONTEXT 3
+
+class ProfileDiff
+{
+ public:
+  ProfileDiff(const Profile *from,const Profile *to,
+	      int context=PROFILEDIFF_DEFAULT_CONTEXT);
+  bool isEmpty() const;
+  int removedLines() const;
+  int addedLines() const;
+  QString unified(const QString &from_label,const QString &to_label) const;
+
+ private:
+  enum Op {Same=0,Removed=1,Added=2};
+  struct Hunk
+  {
+    int from_start;
+    int from_count;
+    int to_start;
+    int to_count;
+    QStringList lines;
+  };
+  void DiffBlocks(const Profile *from,const Profile *to);
+  void DiffBlock(const Profile *from,quint64 from_key,
+		 const Profile *to,quint64 to_key);
+  void DiffValues(const QString &tag,const ProfileValues &from,
+		  const ProfileValues &to);
+  void EmitBlock(Op op,const Profile *p,quint64 key);
+  void EmitValues(Op op,const QString &tag,const ProfileValues &values,
+		  int first,int last);
+  void Emit(Op op,const QString &line);
+  void CloseHunk(int context_lines);
+  static QMap<QString,int> SortedTags(const Profile *p,
+				      const Profile::Block &block);
+  int d_context;
+  int d_from_line;
+  int d_to_line;
+  int d_removed_lines;
+  int d_added_lines;
+  bool d_hunk_open;
+  QStringList d_pending;
+  QList<Hunk> d_hunks;
+};
+
+
+#endif  // PROFILEDIFF_H
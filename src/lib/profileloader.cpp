@@ -0,0 +1,140 @@
+// profileloader.cpp
+//
+// Load a Profile on a worker thread.
+//
+// (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of version 2.1 of the GNU Lesser General Public
+//    License as published by the Free Software Foundation;
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330,
+//    Boston, MA  02111-1307  USA
+//
+// EXEMPLAR_VERSION: 2.0.2
+//
+
+
+#include "profileloader.h"
+
+ProfileLoader::Thread::Thread(Profile *p,const QString &glob_path,
+			      QObject *parent)
+  : QThread(parent)
+{
+  d_profile=p;
+  d_glob_path=glob_path;
+  d_result=-1;
+}
+
+
+Profile *ProfileLoader::Thread::profile() const
+{
+  return d_profile;
+}
+
+
+int ProfileLoader::Thread::result() const
+{
+  return d_result;
+}
+
+
+QStringList ProfileLoader::Thread::errorMessages() const
+{
+  return d_err_msgs;
+}
+
+
+void ProfileLoader::Thread::run()
+{
+  d_result=d_profile->load(d_glob_path,&d_err_msgs);
+}
+
+
+ProfileLoader::ProfileLoader(QObject *parent)
+  : QObject(parent)
+{
+  d_thread=NULL;
+  d_profile=NULL;
+}
+
+
+ProfileLoader::~ProfileLoader()
+{
+  if(d_thread!=NULL) {
+    d_thread->wait();
+    delete d_thread->profile();
+    delete d_thread;
+  }
+  if(d_profile!=NULL) {
+    delete d_profile;
+  }
+}
+
+
+bool ProfileLoader::isLoading() const
+{
+  return d_thread!=NULL;
+}
+
+
+//
+// The loader takes ownership of 'p', which the caller may have set up
+// beforehand (section IDs, concurrent or lazy loading, stats, etc). It is
+// not touched by this thread again until the load has finished, when it
+// replaces the result of any earlier load. If the load cannot be started
+// because 'p' is NULL or another load is still running, false is
+// returned and the caller keeps ownership of 'p'.
+//
+bool ProfileLoader::load(Profile *p,const QString &glob_path)
+{
+  if((p==NULL)||(d_thread!=NULL)) {
+    return false;
+  }
+  d_thread=new Thread(p,glob_path,this);
+  connect(d_thread,SIGNAL(finished()),this,SLOT(threadFinishedData()));
+  d_thread->start();
+
+  return true;
+}
+
+
+Profile *ProfileLoader::profile() const
+{
+  return d_profile;
+}
+
+
+Profile *ProfileLoader::takeProfile()
+{
+  Profile *ret=d_profile;
+
+  d_profile=NULL;
+
+  return ret;
+}
+
+
+void ProfileLoader::threadFinishedData()
+{
+  Thread *thread=d_thread;
+
+  thread->wait();
+  d_thread=NULL;
+  if(d_profile!=NULL) {
+    delete d_profile;
+  }
+  d_profile=thread->profile();
+  int result=thread->result();
+  QStringList err_msgs=thread->errorMessages();
+  thread->deleteLater();
+
+  emit loaded(result,err_msgs);
+}
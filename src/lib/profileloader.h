@@ -0,0 +1,74 @@
+// profileloader.h
+//
+// Load a Profile on a worker thread.
+//
+// (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of version 2.1 of the GNU Lesser General Public
+//    License as published by the Free Software Foundation;
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330,
+//    Boston, MA  02111-1307  USA
+//
+// EXEMPLAR_VERSION: 2.0.2
+//
+
+
+#ifndef PROFILELOADER_H
+#define PROFILELOADER_H
+
+#include <QObject>
+#include <QStringList>
+#include <QThread>
+
+#include "profile.h"
+
+class ProfileLoader : public QObject
+{
+  Q_OBJECT
+ public:
+  ProfileLoader(QObject *parent=0);
+  ~ProfileLoader();
+  bool isLoading() const;
+  bool load(Profile *p,const QString &glob_path);
+  Profile *profile() const;
+  Profile *takeProfile();
+
+ signals:
+  void loaded(int result,const QStringList &err_msgs);
+
+ private slots:
+  void threadFinishedData();
+
+ private:
+  class Thread : public QThread
+  {
+   public:
+    Thread(Profile *p,const QString &glob_path,QObject *parent);
+    Profile *profile() const;
+    int result() const;
+    QStringList errorMessages() const;
+
+   protected:
+    void run();
+
+   private:
+    Profile *d_profile;
+    QString d_glob_path;
+    int d_result;
+    QStringList d_err_msgs;
+  };
+  Thread *d_thread;
+  Profile *d_profile;
+};
+
+
+#endif  // PROFILELOADER_H
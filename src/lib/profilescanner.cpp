@@ -0,0 +1,351 @@
+// profilescanner.cpp
+//
+// Structural scanner for INI data.
+//
+// (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of version 2.1 of the GNU Lesser General Public
+//    License as published by the Free Software Foundation;
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330,
+//    Boston, MA  02111-1307  USA
+//
+// EXEMPLAR_VERSION: 2.0.2
+//
+
+#include <string.h>
+
+#if defined(__x86_64__)||defined(__i386__)
+#define __PROFILESCANNER_X86
+#include <immintrin.h>
+#endif  // __x86_64__ || __i386__
+
+#include <QAtomicInt>
+
+#include "profilescanner.h"
+
+//
+// The kernels classify one 64 byte window at a time, returning a bitmap of
+// the newlines and '=' separators found in it. Brackets and comment markers
+// only have meaning at the ends of a trimmed line, so they are checked when
+// the line is classified rather than carried as extra bitmaps.
+//
+typedef void (*__ProfileScanner_KernelFunc)(const char *,quint64 *,quint64 *);
+
+static void __ProfileScanner_ScalarKernel(const char *data,quint64 *newlines,
+					  quint64 *separators)
+{
+  quint64 nl=0;
+  quint64 sep=0;
+
+  for(int i=0;i<64;i++) {
+    nl|=(quint64)(data[i]=='\n')<<i;
+    sep|=(quint64)(data[i]=='=')<<i;
+  }
+  *newlines=nl;
+  *separators=sep;
+}
+
+
+#ifdef __PROFILESCANNER_X86
+static void __ProfileScanner_Sse2Kernel(const char *data,quint64 *newlines,
+					quint64 *separators)
+    __attribute__((target("sse2")));
+static void __ProfileScanner_Sse2Kernel(const char *data,quint64 *newlines,
+					quint64 *separators)
+{
+  const __m128i nls=_mm_set1_epi8('\n');
+  const __m128i seps=_mm_set1_epi8('=');
+  quint64 nl=0;
+  quint64 sep=0;
+
+  for(int i=0;i<4;i++) {
+    __m128i chunk=_mm_loadu_si128((const __m128i *)(data+16*i));
+    nl|=(quint64)(quint16)_mm_movemask_epi8(_mm_cmpeq_epi8(chunk,nls))<<
+      (16*i);
+    sep|=(quint64)(quint16)_mm_movemask_epi8(_mm_cmpeq_epi8(chunk,seps))<<
+      (16*i);
+  }
+  *newlines=nl;
+  *separators=sep;
+}
+
+
+static void __ProfileScanner_Avx2Kernel(const char *data,quint64 *newlines,
+					quint64 *separators)
+    __attribute__((target("avx2")));
+static void __ProfileScanner_Avx2Kernel(const char *data,quint64 *newlines,
+					quint64 *separators)
+{
+  const __m256i nls=_mm256_set1_epi8('\n');
+  const __m256i seps=_mm256_set1_epi8('=');
+  __m256i lo=_mm256_loadu_si256((const __m256i *)data);
+  __m256i hi=_mm256_loadu_si256((const __m256i *)(data+32));
+
+  *newlines=
+    (quint64)(quint32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(lo,nls))|
+    ((quint64)(quint32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(hi,nls))<<32);
+  *separators=
+    (quint64)(quint32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(lo,seps))|
+    ((quint64)(quint32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(hi,seps))<<32);
+}
+#endif  // __PROFILESCANNER_X86
+
+
+static bool __ProfileScanner_KernelSupported(ProfileScanner::Kernel kern)
+{
+#ifdef __PROFILESCANNER_X86
+  __builtin_cpu_init();
+#endif  // __PROFILESCANNER_X86
+  switch(kern) {
+  case ProfileScanner::Scalar:
+    return true;
+
+  case ProfileScanner::Sse2:
+#ifdef __PROFILESCANNER_X86
+    return __builtin_cpu_supports("sse2");
+#else
+    return false;
+#endif  // __PROFILESCANNER_X86
+
+  case ProfileScanner::Avx2:
+#ifdef __PROFILESCANNER_X86
+    return __builtin_cpu_supports("avx2");
+#else
+    return false;
+#endif  // __PROFILESCANNER_X86
+  }
+
+  return false;
+}
+
+
+static __ProfileScanner_KernelFunc __ProfileScanner_Function(
+					       ProfileScanner::Kernel kern)
+{
+  switch(kern) {
+#ifdef __PROFILESCANNER_X86
+  case ProfileScanner::Avx2:
+    return __ProfileScanner_Avx2Kernel;
+
+  case ProfileScanner::Sse2:
+    return __ProfileScanner_Sse2Kernel;
+#endif  // __PROFILESCANNER_X86
+
+  default:
+    break;
+  }
+
+  return __ProfileScanner_ScalarKernel;
+}
+
+
+//
+// Scanners on other threads may be starting up while the kernel is
+// changed, so it is held atomically and each scanner takes its own copy
+// when it is created.
+//
+static QAtomicInt &__ProfileScanner_ActiveKernel()
+{
+  static QAtomicInt kern(
+    __ProfileScanner_KernelSupported(ProfileScanner::Avx2)?
+    ProfileScanner::Avx2:
+    (__ProfileScanner_KernelSupported(ProfileScanner::Sse2)?
+     ProfileScanner::Sse2:ProfileScanner::Scalar));
+
+  return kern;
+}
+
+
+static inline bool __ProfileScanner_IsSpace(char c)
+{
+  return (c==' ')||((c>='\t')&&(c<='\r'));
+}
+
+
+ProfileScanner::ProfileScanner(const char *data,qint64 len)
+{
+  d_data=data;
+  d_len=len;
+  d_pos=0;
+  d_window_base=-1;
+  d_window_newlines=0;
+  d_window_separators=0;
+  d_kernel=__ProfileScanner_Function(
+	(ProfileScanner::Kernel)__ProfileScanner_ActiveKernel().loadAcquire());
+  d_line_type=ProfileScanner::Blank;
+  d_line_start=data;
+  d_line_end=data;
+  d_separator=NULL;
+
+  //
+  // Skip the UTF-8 byte order mark, if present
+  //
+  if((len>=3)&&(memcmp(data,"\xEF\xBB\xBF",3)==0)) {
+    d_pos=3;
+  }
+}
+
+
+bool ProfileScanner::nextLine()
+{
+  if(d_pos>=d_len) {
+    return false;
+  }
+
+  //
+  // Find the end of the line and the first separator in it
+  //
+  qint64 start=d_pos;
+  qint64 sep=-1;
+  qint64 eol=-1;
+  while(eol<0) {
+    if(d_pos>=d_len) {
+      eol=d_len;
+      break;
+    }
+    qint64 base=d_pos&~(qint64)63;
+    if(base!=d_window_base) {
+      LoadWindow(base);
+    }
+    quint64 mask=~(quint64)0<<(d_pos-base);
+    quint64 nls=d_window_newlines&mask;
+    if(nls!=0) {
+      eol=base+__builtin_ctzll(nls);
+      mask&=~(~(quint64)0<<(eol-base));
+      d_pos=eol+1;
+    }
+    else {
+      d_pos=base+64;
+    }
+    if((sep<0)&&((d_window_separators&mask)!=0)) {
+      sep=base+__builtin_ctzll(d_window_separators&mask);
+    }
+  }
+
+  //
+  // Trim and classify it
+  //
+  const char *first=d_data+start;
+  const char *last=d_data+eol;
+  while((first<last)&&__ProfileScanner_IsSpace(*first)) {
+    first++;
+  }
+  while((last>first)&&__ProfileScanner_IsSpace(*(last-1))) {
+    last--;
+  }
+  d_line_start=first;
+  d_line_end=last;
+  d_separator=NULL;
+  if(first==last) {
+    d_line_type=ProfileScanner::Blank;
+  }
+  else {
+    if((*first==';')||(*first=='#')) {
+      d_line_type=ProfileScanner::Comment;
+    }
+    else {
+      if((last-first>=2)&&(*first=='[')&&(*(last-1)==']')) {
+	d_line_type=ProfileScanner::Section;
+      }
+      else {
+	d_line_type=ProfileScanner::Value;
+	if(sep>=0) {
+	  d_separator=d_data+sep;
+	}
+      }
+    }
+  }
+
+  return true;
+}
+
+
+ProfileScanner::LineType ProfileScanner::lineType() const
+{
+  return d_line_type;
+}
+
+
+const char *ProfileScanner::lineStart() const
+{
+  return d_line_start;
+}
+
+
+const char *ProfileScanner::lineEnd() const
+{
+  return d_line_end;
+}
+
+
+int ProfileScanner::lineLength() const
+{
+  return d_line_end-d_line_start;
+}
+
+
+const char *ProfileScanner::separator() const
+{
+  return d_separator;
+}
+
+
+ProfileScanner::Kernel ProfileScanner::kernel()
+{
+  return (ProfileScanner::Kernel)__ProfileScanner_ActiveKernel().loadAcquire();
+}
+
+
+bool ProfileScanner::setKernel(ProfileScanner::Kernel kern)
+{
+  if(!__ProfileScanner_KernelSupported(kern)) {
+    return false;
+  }
+  __ProfileScanner_ActiveKernel().storeRelease(kern);
+
+  return true;
+}
+
+
+QString ProfileScanner::kernelText(ProfileScanner::Kernel kern)
+{
+  switch(kern) {
+  case ProfileScanner::Scalar:
+    return QString("scalar");
+
+  case ProfileScanner::Sse2:
+    return QString("sse2");
+
+  case ProfileScanner::Avx2:
+    return QString("avx2");
+  }
+
+  return QString("unknown");
+}
+
+
+void ProfileScanner::LoadWindow(qint64 base)
+{
+  if((base+64)<=d_len) {
+    d_kernel(d_data+base,&d_window_newlines,&d_window_separators);
+  }
+  else {
+    //
+    // Pad the tail of the buffer out to a full window
+    //
+    char tail[64];
+    memset(tail,0,64);
+    memcpy(tail,d_data+base,d_len-base);
+    d_kernel(tail,&d_window_newlines,&d_window_separators);
+  }
+  d_window_base=base;
+}
@@ -0,0 +1,61 @@
+// profilescanner.h
+//
+// Structural scanner for INI data.
+//
+// (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of version 2.1 of the GNU Lesser General Public
+//    License as published by the Free Software Foundation;
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330,
+//    Boston, MA  02111-1307  USA
+//
+// EXEMPLAR_VERSION: 2.0.2
+//
+
+#ifndef PROFILESCANNER_H
+#define PROFILESCANNER_H
+
+#include <QString>
+
+class ProfileScanner
+{
+ public:
+  enum LineType {Blank=0,Comment=1,Section=2,Value=3};
+  enum Kernel {Scalar=0,Sse2=1,Avx2=2};
+  ProfileScanner(const char *data,qint64 len);
+  bool nextLine();
+  LineType lineType() const;
+  const char *lineStart() const;
+  const char *lineEnd() const;
+  int lineLength() const;
+  const char *separator() const;
+  static Kernel kernel();
+  static bool setKernel(Kernel kern);
+  static QString kernelText(Kernel kern);
+
+ private:
+  void LoadWindow(qint64 base);
+  const char *d_data;
+  qint64 d_len;
+  qint64 d_pos;
+  qint64 d_window_base;
+  quint64 d_window_newlines;
+  quint64 d_window_separators;
+  void (*d_kernel)(const char *,quint64 *,quint64 *);
+  LineType d_line_type;
+  const char *d_line_start;
+  const char *d_line_end;
+  const char *d_separator;
+};
+
+
+#endif  // PROFILESCANNER_H
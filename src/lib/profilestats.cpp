@@ -0,0 +1,251 @@
+// profilestats.cpp
+//
+// Runtime statistics for a Profile.
+//
+// (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of version 2.1 of the GNU Lesser General Public
+//    License as published by the Free Software Foundation;
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330,
+//    Boston, MA  02111-1307  USA
+//
+// EXEMPLAR_VERSION: 2.0.2
+//
+
+#include "profilestats.h"
+
+ProfileStats::ProfileStats()
+{
+  d_enabled=false;
+  d_section_count=0;
+  d_pending_section_count=0;
+  d_tag_count=0;
+  d_value_count=0;
+  d_heap_bytes=0;
+  for(int i=0;i<ProfileStats::LastType;i++) {
+    d_hits[i]=0;
+    d_misses[i]=0;
+  }
+  d_layer_count=1;
+  for(int i=0;i<PROFILESTATS_MAX_LAYERS;i++) {
+    d_layer_hits[i]=0;
+  }
+}
+
+
+bool ProfileStats::isEnabled() const
+{
+  return d_enabled;
+}
+
+
+QList<ProfileStats::File> ProfileStats::files() const
+{
+  return d_files;
+}
+
+
+int ProfileStats::sectionCount() const
+{
+  return d_section_count;
+}
+
+
+int ProfileStats::pendingSectionCount() const
+{
+  return d_pending_section_count;
+}
+
+
+int ProfileStats::tagCount() const
+{
+  return d_tag_count;
+}
+
+
+int ProfileStats::valueCount() const
+{
+  return d_value_count;
+}
+
+
+qint64 ProfileStats::heapBytes() const
+{
+  return d_heap_bytes;
+}
+
+
+quint64 ProfileStats::calls(ProfileStats::Type type) const
+{
+  return d_hits[type]+d_misses[type];
+}
+
+
+quint64 ProfileStats::hits(ProfileStats::Type type) const
+{
+  return d_hits[type];
+}
+
+
+quint64 ProfileStats::misses(ProfileStats::Type type) const
+{
+  return d_misses[type];
+}
+
+
+quint64 ProfileStats::totalCalls() const
+{
+  return totalHits()+totalMisses();
+}
+
+
+quint64 ProfileStats::totalHits() const
+{
+  quint64 ret=0;
+
+  for(int i=0;i<ProfileStats::LastType;i++) {
+    ret+=d_hits[i];
+  }
+
+  return ret;
+}
+
+
+quint64 ProfileStats::totalMisses() const
+{
+  quint64 ret=0;
+
+  for(int i=0;i<ProfileStats::LastType;i++) {
+    ret+=d_misses[i];
+  }
+
+  return ret;
+}
+
+
+int ProfileStats::layerCount() const
+{
+  return d_layer_count;
+}
+
+
+//
+// Layer 0 is the profile itself, layer 1 its base, and so on.
+//
+quint64 ProfileStats::layerHits(int layer) const
+{
+  if((layer<0)||(layer>=PROFILESTATS_MAX_LAYERS)) {
+    return 0;
+  }
+  return d_layer_hits[layer];
+}
+
+
+QString ProfileStats::dump() const
+{
+  QString ret;
+  qint64 bytes=0;
+  qint64 nsecs=0;
+
+  ret+="[Files]\n";
+  for(int i=0;i<d_files.size();i++) {
+    const ProfileStats::File &file=d_files.at(i);
+    ret+=QString::asprintf("%s: %lld bytes, %.3lf ms%s\n",
+			   file.path.isEmpty()?"(memory)":
+			   file.path.toUtf8().constData(),
+			   (long long)file.bytes,(double)file.nsecs/1000000.0,
+			   file.cached?" (cached)":"");
+    bytes+=file.bytes;
+    nsecs+=file.nsecs;
+  }
+  ret+=QString::asprintf("Total: %lld bytes, %.3lf ms\n",
+			 (long long)bytes,(double)nsecs/1000000.0);
+  ret+="\n";
+
+  ret+="[Contents]\n";
+  ret+=QString::asprintf("Sections: %d\n",d_section_count);
+  if(d_pending_section_count>0) {
+    ret+=QString::asprintf("PendingSections: %d\n",d_pending_section_count);
+  }
+  ret+=QString::asprintf("Tags: %d\n",d_tag_count);
+  ret+=QString::asprintf("Values: %d\n",d_value_count);
+  ret+=QString::asprintf("HeapBytes: %lld\n",(long long)d_heap_bytes);
+  ret+="\n";
+
+  ret+="[Lookups]\n";
+  for(int i=0;i<ProfileStats::LastType;i++) {
+    ProfileStats::Type type=(ProfileStats::Type)i;
+    ret+=QString::asprintf("%s: %llu calls, %llu hits, %llu misses\n",
+			   typeText(type).toUtf8().constData(),
+			   (unsigned long long)calls(type),
+			   (unsigned long long)hits(type),
+			   (unsigned long long)misses(type));
+  }
+  ret+=QString::asprintf("Total: %llu calls, %llu hits, %llu misses\n",
+			 (unsigned long long)totalCalls(),
+			 (unsigned long long)totalHits(),
+			 (unsigned long long)totalMisses());
+  if(d_layer_count>1) {
+    ret+="\n";
+    ret+="[Layers]\n";
+    for(int i=0;i<qMin(d_layer_count,PROFILESTATS_MAX_LAYERS);i++) {
+      ret+=QString::asprintf("Layer%d: %llu hits\n",i,
+			     (unsigned long long)d_layer_hits[i]);
+    }
+  }
+
+  return ret;
+}
+
+
+QString ProfileStats::typeText(ProfileStats::Type type)
+{
+  switch(type) {
+  case ProfileStats::String:
+    return QString("String");
+
+  case ProfileStats::Int:
+    return QString("Int");
+
+  case ProfileStats::Hex:
+    return QString("Hex");
+
+  case ProfileStats::Double:
+    return QString("Double");
+
+  case ProfileStats::Bool:
+    return QString("Bool");
+
+  case ProfileStats::Time:
+    return QString("Time");
+
+  case ProfileStats::Address:
+    return QString("Address");
+
+  case ProfileStats::Count:
+    return QString("Count");
+
+  case ProfileStats::LastType:
+    break;
+  }
+
+  return QString("Unknown");
+}
+
+
+qint64 ProfileStats::stringBytes(const QString &str)
+{
+  if(str.isNull()) {
+    return 0;
+  }
+  return PROFILESTATS_ARRAY_HEADER_BYTES+2*(str.capacity()+1);
+}
@@ -0,0 +1,92 @@
+// profilestats.h
+//
+// Runtime statistics for a Profile.
+//
+// (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of version 2.1 of the GNU Lesser General Public
+//    License as published by the Free Software Foundation;
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330,
+//    Boston, MA  02111-1307  USA
+//
+// EXEMPLAR_VERSION: 2.0.2
+//
+
+#ifndef PROFILESTATS_H
+#define PROFILESTATS_H
+
+#include <QList>
+#include <QString>
+
+//
+// Allocation sizes used when estimating heap usage. These follow Qt 5's
+// 64 bit layouts and ignore allocator rounding.
+//
+#define PROFILESTATS_ARRAY_HEADER_BYTES 24
+#define PROFILESTATS_HASH_NODE_BYTES 32
+#define PROFILESTATS_POINTER_BYTES 8
+
+//
+// Lookups answered by layers deeper than this are counted against the
+// deepest one.
+//
+#define PROFILESTATS_MAX_LAYERS 16
+
+class ProfileStats
+{
+ public:
+  enum Type {String=0,Int=1,Hex=2,Double=3,Bool=4,Time=5,Address=6,
+	     Count=7,LastType=8};
+  struct File
+  {
+    QString path;
+    qint64 bytes;
+    qint64 nsecs;
+    bool cached;
+  };
+  ProfileStats();
+  bool isEnabled() const;
+  QList<File> files() const;
+  int sectionCount() const;
+  int pendingSectionCount() const;
+  int tagCount() const;
+  int valueCount() const;
+  qint64 heapBytes() const;
+  quint64 calls(Type type) const;
+  quint64 hits(Type type) const;
+  quint64 misses(Type type) const;
+  quint64 totalCalls() const;
+  quint64 totalHits() const;
+  quint64 totalMisses() const;
+  int layerCount() const;
+  quint64 layerHits(int layer) const;
+  QString dump() const;
+  static QString typeText(Type type);
+  static qint64 stringBytes(const QString &str);
+
+ private:
+  bool d_enabled;
+  QList<File> d_files;
+  int d_section_count;
+  int d_pending_section_count;
+  int d_tag_count;
+  int d_value_count;
+  qint64 d_heap_bytes;
+  quint64 d_hits[LastType];
+  quint64 d_misses[LastType];
+  int d_layer_count;
+  quint64 d_layer_hits[PROFILESTATS_MAX_LAYERS];
+  friend class Profile;
+};
+
+
+#endif  // PROFILESTATS_H
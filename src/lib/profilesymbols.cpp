@@ -0,0 +1,83 @@
+// profilesymbols.cpp
+//
+// Interned symbol table for Profile names.
+//
+// (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of version 2.1 of the GNU Lesser General Public
+//    License as published by the Free Software Foundation;
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330,
+//    Boston, MA  02111-1307  USA
+//
+// EXEMPLAR_VERSION: 2.0.2
+//
+
+#include "profilestats.h"
+#include "profilesymbols.h"
+
+ProfileSymbols::ProfileSymbols()
+{
+}
+
+
+int ProfileSymbols::symbol(const QString &name) const
+{
+  return d_symbols.value(name,-1);
+}
+
+
+int ProfileSymbols::intern(const QString &name)
+{
+  QHash<QString,int>::const_iterator it=d_symbols.constFind(name);
+  if(it!=d_symbols.constEnd()) {
+    return it.value();
+  }
+  d_symbols[name]=d_names.size();
+  d_names.push_back(name);
+
+  return d_names.size()-1;
+}
+
+
+const QString &ProfileSymbols::name(int sym) const
+{
+  return d_names.at(sym);
+}
+
+
+int ProfileSymbols::size() const
+{
+  return d_names.size();
+}
+
+
+qint64 ProfileSymbols::heapBytes() const
+{
+  //
+  // The hash keys share their data with 'd_names'
+  //
+  qint64 ret=PROFILESTATS_HASH_NODE_BYTES*d_symbols.size()+
+    PROFILESTATS_POINTER_BYTES*d_symbols.capacity()+
+    PROFILESTATS_POINTER_BYTES*d_names.size();
+  for(int i=0;i<d_names.size();i++) {
+    ret+=ProfileStats::stringBytes(d_names.at(i));
+  }
+
+  return ret;
+}
+
+
+void ProfileSymbols::clear()
+{
+  d_symbols.clear();
+  d_names.clear();
+}
@@ -0,0 +1,48 @@
+// profilesymbols.h
+//
+// Interned symbol table for Profile names.
+//
+// (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of version 2.1 of the GNU Lesser General Public
+//    License as published by the Free Software Foundation;
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330,
+//    Boston, MA  02111-1307  USA
+//
+// EXEMPLAR_VERSION: 2.0.2
+//
+
+#ifndef PROFILESYMBOLS_H
+#define PROFILESYMBOLS_H
+
+#include <QHash>
+#include <QString>
+#include <QStringList>
+
+class ProfileSymbols
+{
+ public:
+  ProfileSymbols();
+  int symbol(const QString &name) const;
+  int intern(const QString &name);
+  const QString &name(int sym) const;
+  int size() const;
+  qint64 heapBytes() const;
+  void clear();
+
+ private:
+  QHash<QString,int> d_symbols;
+  QStringList d_names;
+};
+
+
+#endif  // PROFILESYMBOLS_H
@@ -0,0 +1,724 @@
+// profilevalues.cpp
+//
+// Container for the values of a Profile tag.
+//
+// (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of version 2.1 of the GNU Lesser General Public
+//    License as published by the Free Software Foundation;
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330,
+//    Boston, MA  02111-1307  USA
+//
+// EXEMPLAR_VERSION: 2.0.2
+//
+
+#include <string.h>
+
+#include <QtEndian>
+
+#include "profilestats.h"
+#include "profilevalues.h"
+
+//
+// Values are kept as UTF-8 in fixed size slots. Anything up to 15 bytes
+// long is stored inline, with its length in the last byte of the slot;
+// longer values go into one contiguous buffer per tag, and their slot
+// holds the offset and length instead.
+//
+#define __PROFILEVALUES_INLINE_SIZE 15
+#define __PROFILEVALUES_OUT_OF_LINE 0xFF
+
+//
+// Mantissas saturate here: anything larger is out of range for an int and
+// cannot be converted exactly by the fast path in __ProfileValues_ParseDouble.
+//
+#define __PROFILEVALUES_MANTISSA_LIMIT ((quint64)1<<53)
+
+//
+// Each view of the values is converted the first time it is asked for and
+// then kept. Concurrent readers may race to build the same view; the first
+// one to publish it wins and the others throw theirs away.
+//
+template<class L>
+static const L &__ProfileValues_Cached(QAtomicPointer<L> *cache,
+				       const ProfileValues *values,
+				       typename L::value_type (*convert)(
+						       const char *,int))
+{
+  L *list=cache->loadAcquire();
+  if(list==NULL) {
+    list=new L();
+    list->reserve(values->size());
+    for(int i=0;i<values->size();i++) {
+      int len=0;
+      const char *data=values->utf8(i,&len);
+      list->push_back(convert(data,len));
+    }
+    if(!cache->testAndSetOrdered(NULL,list)) {
+      delete list;
+      list=cache->loadAcquire();
+    }
+  }
+  return *list;
+}
+
+
+template<class L>
+static void __ProfileValues_Clear(QAtomicPointer<L> *cache)
+{
+  if(cache->loadAcquire()!=NULL) {
+    delete cache->fetchAndStoreOrdered(NULL);
+  }
+}
+
+
+//
+// References handed out from a view must outlive later appends, so a view
+// that goes stale is set aside rather than deleted. Set-aside views are
+// freed by clear(), by assignment and along with the values themselves,
+// after which no reference into them may be used.
+//
+template<class L>
+static void __ProfileValues_Retire(QAtomicPointer<L> *cache,
+				   QList<L *> *retired)
+{
+  if(cache->loadAcquire()!=NULL) {
+    retired->push_back(cache->fetchAndStoreOrdered(NULL));
+  }
+}
+
+
+template<class L>
+static qint64 __ProfileValues_ListBytes(const L *list)
+{
+  if(list==NULL) {
+    return 0;
+  }
+  return (qint64)sizeof(L)+PROFILESTATS_ARRAY_HEADER_BYTES+
+    PROFILESTATS_POINTER_BYTES*list->size();
+}
+
+
+template<class L>
+static qint64 __ProfileValues_CacheBytes(const QAtomicPointer<L> *cache)
+{
+  return __ProfileValues_ListBytes(cache->loadAcquire());
+}
+
+
+template<class L>
+static qint64 __ProfileValues_RetiredBytes(const QList<L *> &retired)
+{
+  qint64 ret=0;
+
+  for(int i=0;i<retired.size();i++) {
+    ret+=__ProfileValues_ListBytes(retired.at(i));
+  }
+
+  return ret;
+}
+
+
+struct ProfileValues::Retired
+{
+  QList<QStringList *> strings;
+  QList<QList<int> *> ints;
+  QList<QList<int> *> hexes;
+  QList<QList<double> *> doubles;
+  QList<QList<bool> *> bools;
+  QList<QList<QTime> *> times;
+  QList<QList<QHostAddress> *> addresses;
+};
+
+
+//
+// Locale-independent parsers. These accept exactly what QString::toInt()
+// and QString::toDouble() accept in the C locale, and hand anything unusual
+// to QString::toDouble() rather than guess.
+//
+static inline bool __ProfileValues_IsSpace(char c)
+{
+  return (c==' ')||((c>='\t')&&(c<='\r'));
+}
+
+
+static inline void __ProfileValues_Trim(const char **start,const char **end)
+{
+  while((*start<*end)&&__ProfileValues_IsSpace(**start)) {
+    (*start)++;
+  }
+  while((*end>*start)&&__ProfileValues_IsSpace(*(*end-1))) {
+    (*end)--;
+  }
+}
+
+
+//
+// Accumulate a run of decimal digits into 'acc', saturating at the mantissa
+// limit, and return a pointer to the first non-digit. Eight digits at a
+// time are checked and combined within a single 64 bit word.
+//
+static const char *__ProfileValues_Digits(const char *p,const char *end,
+					  quint64 *acc)
+{
+  quint64 val=*acc;
+
+  while((end-p)>=8) {
+    quint64 word;
+    memcpy(&word,p,8);
+    word=qFromLittleEndian(word);
+    if(((word&0xF0F0F0F0F0F0F0F0ull)!=0x3030303030303030ull)||
+       (((word+0x0606060606060606ull)&0xF0F0F0F0F0F0F0F0ull)!=
+	0x3030303030303030ull)) {
+      break;
+    }
+    word-=0x3030303030303030ull;
+    word=(word*10+(word>>8))&0x00FF00FF00FF00FFull;
+    word=(word*100+(word>>16))&0x0000FFFF0000FFFFull;
+    word=(word*10000+(word>>32))&0xFFFFFFFFull;
+    if(val>(__PROFILEVALUES_MANTISSA_LIMIT/100000000)) {
+      val=__PROFILEVALUES_MANTISSA_LIMIT;
+    }
+    else {
+      val=qMin(val*100000000+word,__PROFILEVALUES_MANTISSA_LIMIT);
+    }
+    p+=8;
+  }
+  while((p<end)&&(*p>='0')&&(*p<='9')) {
+    if(val>(__PROFILEVALUES_MANTISSA_LIMIT/10)) {
+      val=__PROFILEVALUES_MANTISSA_LIMIT;
+    }
+    else {
+      val=qMin(val*10+(*p-'0'),__PROFILEVALUES_MANTISSA_LIMIT);
+    }
+    p++;
+  }
+  *acc=val;
+
+  return p;
+}
+
+
+static bool __ProfileValues_ParseInt(const char *data,int len,int base,
+				     int *value)
+{
+  const char *p=data;
+  const char *end=data+len;
+  bool neg=false;
+  quint64 acc=0;
+
+  *value=0;
+  __ProfileValues_Trim(&p,&end);
+  if((p<end)&&((*p=='-')||(*p=='+'))) {
+    neg=*p++=='-';
+  }
+  const char *digits=p;
+  if(base==10) {
+    p=__ProfileValues_Digits(p,end,&acc);
+  }
+  else {
+    if(((end-p)>2)&&(p[0]=='0')&&((p[1]=='x')||(p[1]=='X'))) {
+      digits=p+=2;
+    }
+    for(;p<end;p++) {
+      int d;
+      if((*p>='0')&&(*p<='9')) {
+	d=*p-'0';
+      }
+      else {
+	if((*p>='a')&&(*p<='f')) {
+	  d=*p-'a'+10;
+	}
+	else {
+	  if((*p>='A')&&(*p<='F')) {
+	    d=*p-'A'+10;
+	  }
+	  else {
+	    break;
+	  }
+	}
+      }
+      acc=qMin(acc*16+d,__PROFILEVALUES_MANTISSA_LIMIT);
+    }
+  }
+  if((p==digits)||(p!=end)||(acc>(neg?0x80000000ull:0x7FFFFFFFull))) {
+    return false;
+  }
+  *value=neg?(int)(-(qint64)acc):(int)acc;
+
+  return true;
+}
+
+
+static bool __ProfileValues_ParseDouble(const char *data,int len,
+					double *value)
+{
+  static const double powers[]={1e0,1e1,1e2,1e3,1e4,1e5,1e6,1e7,1e8,1e9,
+				1e10,1e11,1e12,1e13,1e14,1e15,1e16,1e17,
+				1e18,1e19,1e20,1e21,1e22};
+  const char *p=data;
+  const char *end=data+len;
+  bool neg=false;
+  quint64 mantissa=0;
+  int exponent=0;
+
+  //
+  // Fast path: a plain decimal with at most 2^53 for a mantissa and a power
+  // of ten that is exact as a double converts with a single correctly
+  // rounded multiply or divide.
+  //
+  __ProfileValues_Trim(&p,&end);
+  if((p<end)&&((*p=='-')||(*p=='+'))) {
+    neg=*p++=='-';
+  }
+  const char *digits=p;
+  p=__ProfileValues_Digits(p,end,&mantissa);
+  bool fast=p>digits;
+  if(fast&&(p<end)&&(*p=='.')) {
+    const char *frac=++p;
+    p=__ProfileValues_Digits(p,end,&mantissa);
+    exponent=-(int)(p-frac);
+    fast=p>frac;
+  }
+  if(fast&&(p<end)&&((*p=='e')||(*p=='E'))) {
+    bool exp_neg=false;
+    quint64 exp=0;
+    p++;
+    if((p<end)&&((*p=='-')||(*p=='+'))) {
+      exp_neg=*p++=='-';
+    }
+    const char *exp_digits=p;
+    p=__ProfileValues_Digits(p,end,&exp);
+    fast=(p>exp_digits)&&(exp<=22);
+    exponent+=exp_neg?-(int)exp:(int)exp;
+  }
+  if(fast&&(p==end)&&(mantissa<__PROFILEVALUES_MANTISSA_LIMIT)&&
+     (exponent>=-22)&&(exponent<=22)) {
+    double ret=(double)mantissa;
+    if(exponent<0) {
+      ret/=powers[-exponent];
+    }
+    else {
+      ret*=powers[exponent];
+    }
+    *value=neg?-ret:ret;
+    return true;
+  }
+
+  bool ok=false;
+  *value=QString::fromUtf8(data,len).toDouble(&ok);
+  if(!ok) {
+    *value=0.0;
+  }
+
+  return ok;
+}
+
+
+static QString __ProfileValues_ToString(const char *data,int len)
+{
+  return QString::fromUtf8(data,len);
+}
+
+
+static int __ProfileValues_ToInt(const char *data,int len)
+{
+  int ret=0;
+
+  __ProfileValues_ParseInt(data,len,10,&ret);
+
+  return ret;
+}
+
+
+static int __ProfileValues_ToHex(const char *data,int len)
+{
+  int ret=0;
+
+  __ProfileValues_ParseInt(data,len,16,&ret);
+
+  return ret;
+}
+
+
+static double __ProfileValues_ToDouble(const char *data,int len)
+{
+  double ret=0.0;
+
+  __ProfileValues_ParseDouble(data,len,&ret);
+
+  return ret;
+}
+
+
+static bool __ProfileValues_ToBool(const char *data,int len)
+{
+  static const char *trues[]={"yes","true","on","1",NULL};
+
+  for(int i=0;trues[i]!=NULL;i++) {
+    if(((int)strlen(trues[i])==len)&&(qstrnicmp(data,trues[i],len)==0)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+
+static QTime __ProfileValues_ToTime(const char *data,int len)
+{
+  QStringList fields=QString::fromUtf8(data,len).split(":");
+  if(fields.size()==2) {
+    return QTime(fields.at(0).toInt(),fields.at(1).toInt(),0);
+  }
+  if(fields.size()==3) {
+    return QTime(fields.at(0).toInt(),fields.at(1).toInt(),
+		 fields.at(2).toInt());
+  }
+  return QTime();
+}
+
+
+static QHostAddress __ProfileValues_ToAddress(const char *data,int len)
+{
+  return QHostAddress(QString::fromUtf8(data,len));
+}
+
+
+ProfileValues::ProfileValues()
+{
+  d_retired=NULL;
+}
+
+
+ProfileValues::ProfileValues(const ProfileValues &other)
+{
+  d_data=other.d_data;
+  d_slots=other.d_slots;
+  d_retired=NULL;
+}
+
+
+ProfileValues::~ProfileValues()
+{
+  ClearCache();
+}
+
+
+ProfileValues &ProfileValues::operator=(const ProfileValues &other)
+{
+  if(this!=&other) {
+    d_data=other.d_data;
+    d_slots=other.d_slots;
+    ClearCache();
+  }
+  return *this;
+}
+
+
+int ProfileValues::size() const
+{
+  return d_slots.size();
+}
+
+
+QString ProfileValues::value(int n) const
+{
+  int len=0;
+  const char *data=utf8(n,&len);
+
+  return QString::fromUtf8(data,len);
+}
+
+
+const char *ProfileValues::utf8(int n,int *len) const
+{
+  const Slot &slot=d_slots.at(n);
+  quint8 size=slot.bytes[__PROFILEVALUES_INLINE_SIZE];
+
+  if(size!=__PROFILEVALUES_OUT_OF_LINE) {
+    *len=size;
+    return slot.bytes;
+  }
+  quint32 offset;
+  quint32 length;
+  memcpy(&offset,slot.bytes,4);
+  memcpy(&length,slot.bytes+4,4);
+  *len=length;
+
+  return d_data.constData()+offset;
+}
+
+
+//
+// Decoded afresh on every call. Only stringValues(), which backs
+// Profile::stringValuesRef() and Profile::valueAt(), keeps a decoded copy,
+// as it has to for the references it hands out; tags that are just read
+// as strings stay in their compact form.
+//
+QStringList ProfileValues::toStrings() const
+{
+  QStringList ret;
+
+  ret.reserve(d_slots.size());
+  for(int i=0;i<d_slots.size();i++) {
+    ret.push_back(value(i));
+  }
+
+  return ret;
+}
+
+
+const QStringList &ProfileValues::stringValues() const
+{
+  return __ProfileValues_Cached(&d_strings,this,__ProfileValues_ToString);
+}
+
+
+const QList<int> &ProfileValues::intValues() const
+{
+  return __ProfileValues_Cached(&d_ints,this,__ProfileValues_ToInt);
+}
+
+
+const QList<int> &ProfileValues::hexValues() const
+{
+  return __ProfileValues_Cached(&d_hexes,this,__ProfileValues_ToHex);
+}
+
+
+const QList<double> &ProfileValues::doubleValues() const
+{
+  return __ProfileValues_Cached(&d_doubles,this,__ProfileValues_ToDouble);
+}
+
+
+const QList<bool> &ProfileValues::boolValues() const
+{
+  return __ProfileValues_Cached(&d_bools,this,__ProfileValues_ToBool);
+}
+
+
+const QList<QTime> &ProfileValues::timeValues() const
+{
+  return __ProfileValues_Cached(&d_times,this,__ProfileValues_ToTime);
+}
+
+
+const QList<QHostAddress> &ProfileValues::addressValues() const
+{
+  return __ProfileValues_Cached(&d_addresses,this,__ProfileValues_ToAddress);
+}
+
+
+int ProfileValues::toInts(int *values,int max,QList<int> *errors) const
+{
+  int count=qMin(max,d_slots.size());
+
+  for(int i=0;i<count;i++) {
+    int len=0;
+    const char *data=utf8(i,&len);
+    if((!__ProfileValues_ParseInt(data,len,10,values+i))&&(errors!=NULL)) {
+      errors->push_back(i);
+    }
+  }
+  return count;
+}
+
+
+int ProfileValues::toHexes(int *values,int max,QList<int> *errors) const
+{
+  int count=qMin(max,d_slots.size());
+
+  for(int i=0;i<count;i++) {
+    int len=0;
+    const char *data=utf8(i,&len);
+    if((!__ProfileValues_ParseInt(data,len,16,values+i))&&(errors!=NULL)) {
+      errors->push_back(i);
+    }
+  }
+  return count;
+}
+
+
+int ProfileValues::toDoubles(double *values,int max,QList<int> *errors) const
+{
+  int count=qMin(max,d_slots.size());
+
+  for(int i=0;i<count;i++) {
+    int len=0;
+    const char *data=utf8(i,&len);
+    if((!__ProfileValues_ParseDouble(data,len,values+i))&&(errors!=NULL)) {
+      errors->push_back(i);
+    }
+  }
+  return count;
+}
+
+
+qint64 ProfileValues::heapBytes() const
+{
+  qint64 ret=0;
+
+  if(d_data.capacity()>0) {
+    ret+=PROFILESTATS_ARRAY_HEADER_BYTES+d_data.capacity();
+  }
+  if(d_slots.capacity()>0) {
+    ret+=PROFILESTATS_ARRAY_HEADER_BYTES+sizeof(Slot)*d_slots.capacity();
+  }
+  QList<const QStringList *> strings;
+  strings.push_back(d_strings.loadAcquire());
+  if(d_retired!=NULL) {
+    for(int i=0;i<d_retired->strings.size();i++) {
+      strings.push_back(d_retired->strings.at(i));
+    }
+  }
+  for(int i=0;i<strings.size();i++) {
+    if(strings.at(i)!=NULL) {
+      for(int j=0;j<strings.at(i)->size();j++) {
+	ret+=ProfileStats::stringBytes(strings.at(i)->at(j));
+      }
+    }
+  }
+  ret+=__ProfileValues_CacheBytes(&d_strings);
+  ret+=__ProfileValues_CacheBytes(&d_ints);
+  ret+=__ProfileValues_CacheBytes(&d_hexes);
+  ret+=__ProfileValues_CacheBytes(&d_doubles);
+  ret+=__ProfileValues_CacheBytes(&d_bools);
+  ret+=__ProfileValues_CacheBytes(&d_times);
+  ret+=__ProfileValues_CacheBytes(&d_addresses);
+  if(d_retired!=NULL) {
+    ret+=sizeof(Retired);
+    ret+=__ProfileValues_RetiredBytes(d_retired->strings);
+    ret+=__ProfileValues_RetiredBytes(d_retired->ints);
+    ret+=__ProfileValues_RetiredBytes(d_retired->hexes);
+    ret+=__ProfileValues_RetiredBytes(d_retired->doubles);
+    ret+=__ProfileValues_RetiredBytes(d_retired->bools);
+    ret+=__ProfileValues_RetiredBytes(d_retired->times);
+    ret+=__ProfileValues_RetiredBytes(d_retired->addresses);
+  }
+
+  return ret;
+}
+
+
+void ProfileValues::append(const char *data,int len)
+{
+  Slot slot;
+
+  if(len<=__PROFILEVALUES_INLINE_SIZE) {
+    memcpy(slot.bytes,data,len);
+    slot.bytes[__PROFILEVALUES_INLINE_SIZE]=(char)len;
+  }
+  else {
+    quint32 offset=d_data.size();
+    quint32 length=len;
+    d_data.append(data,len);
+    memcpy(slot.bytes,&offset,4);
+    memcpy(slot.bytes+4,&length,4);
+    slot.bytes[__PROFILEVALUES_INLINE_SIZE]=(char)__PROFILEVALUES_OUT_OF_LINE;
+  }
+  d_slots.push_back(slot);
+  RetireCache();
+}
+
+
+void ProfileValues::append(const QString &value)
+{
+  QByteArray data=value.toUtf8();
+
+  append(data.constData(),data.size());
+}
+
+
+void ProfileValues::append(QStringView value)
+{
+  QByteArray data=value.toUtf8();
+
+  append(data.constData(),data.size());
+}
+
+
+void ProfileValues::append(const QStringList &values)
+{
+  for(int i=0;i<values.size();i++) {
+    append(values.at(i));
+  }
+}
+
+
+void ProfileValues::append(const ProfileValues &values)
+{
+  if(d_slots.isEmpty()) {
+    d_data=values.d_data;
+    d_slots=values.d_slots;
+    RetireCache();
+    return;
+  }
+  d_slots.reserve(d_slots.size()+values.size());
+  for(int i=0;i<values.size();i++) {
+    int len=0;
+    const char *data=values.utf8(i,&len);
+    append(data,len);
+  }
+}
+
+
+void ProfileValues::clear()
+{
+  d_data.clear();
+  d_slots.clear();
+  ClearCache();
+}
+
+
+void ProfileValues::ClearCache()
+{
+  __ProfileValues_Clear(&d_strings);
+  __ProfileValues_Clear(&d_ints);
+  __ProfileValues_Clear(&d_hexes);
+  __ProfileValues_Clear(&d_doubles);
+  __ProfileValues_Clear(&d_bools);
+  __ProfileValues_Clear(&d_times);
+  __ProfileValues_Clear(&d_addresses);
+  if(d_retired!=NULL) {
+    qDeleteAll(d_retired->strings);
+    qDeleteAll(d_retired->ints);
+    qDeleteAll(d_retired->hexes);
+    qDeleteAll(d_retired->doubles);
+    qDeleteAll(d_retired->bools);
+    qDeleteAll(d_retired->times);
+    qDeleteAll(d_retired->addresses);
+    delete d_retired;
+    d_retired=NULL;
+  }
+}
+
+
+void ProfileValues::RetireCache()
+{
+  if((d_strings.loadAcquire()==NULL)&&(d_ints.loadAcquire()==NULL)&&
+     (d_hexes.loadAcquire()==NULL)&&(d_doubles.loadAcquire()==NULL)&&
+     (d_bools.loadAcquire()==NULL)&&(d_times.loadAcquire()==NULL)&&
+     (d_addresses.loadAcquire()==NULL)) {
+    return;
+  }
+  if(d_retired==NULL) {
+    d_retired=new Retired();
+  }
+  __ProfileValues_Retire(&d_strings,&d_retired->strings);
+  __ProfileValues_Retire(&d_ints,&d_retired->ints);
+  __ProfileValues_Retire(&d_hexes,&d_retired->hexes);
+  __ProfileValues_Retire(&d_doubles,&d_retired->doubles);
+  __ProfileValues_Retire(&d_bools,&d_retired->bools);
+  __ProfileValues_Retire(&d_times,&d_retired->times);
+  __ProfileValues_Retire(&d_addresses,&d_retired->addresses);
+}
@@ -0,0 +1,91 @@
+// profilevalues.h
+//
+// Container for the values of a Profile tag.
+//
+// (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of version 2.1 of the GNU Lesser General Public
+//    License as published by the Free Software Foundation;
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330,
+//    Boston, MA  02111-1307  USA
+//
+// EXEMPLAR_VERSION: 2.0.2
+//
+
+#ifndef PROFILEVALUES_H
+#define PROFILEVALUES_H
+
+#include <QAtomicPointer>
+#include <QByteArray>
+#include <QHostAddress>
+#include <QList>
+#include <QStringList>
+#include <QStringView>
+#include <QTime>
+#include <QVector>
+
+//
+// References returned by the typed views (stringValues(), intValues(),
+// etc) stay valid across append(), but not across clear(), assignment or
+// destruction, which free every view built so far.
+//
+class ProfileValues
+{
+ public:
+  ProfileValues();
+  ProfileValues(const ProfileValues &other);
+  ~ProfileValues();
+  ProfileValues &operator=(const ProfileValues &other);
+  int size() const;
+  QString value(int n) const;
+  const char *utf8(int n,int *len) const;
+  QStringList toStrings() const;
+  const QStringList &stringValues() const;
+  const QList<int> &intValues() const;
+  const QList<int> &hexValues() const;
+  const QList<double> &doubleValues() const;
+  const QList<bool> &boolValues() const;
+  const QList<QTime> &timeValues() const;
+  const QList<QHostAddress> &addressValues() const;
+  int toInts(int *values,int max,QList<int> *errors=NULL) const;
+  int toHexes(int *values,int max,QList<int> *errors=NULL) const;
+  int toDoubles(double *values,int max,QList<int> *errors=NULL) const;
+  qint64 heapBytes() const;
+  void append(const char *data,int len);
+  void append(const QString &value);
+  void append(QStringView value);
+  void append(const QStringList &values);
+  void append(const ProfileValues &values);
+  void clear();
+
+ private:
+  struct Slot
+  {
+    char bytes[16];
+  };
+  void ClearCache();
+  void RetireCache();
+  struct Retired;
+  QByteArray d_data;
+  QVector<Slot> d_slots;
+  mutable QAtomicPointer<QStringList> d_strings;
+  mutable QAtomicPointer<QList<int> > d_ints;
+  mutable QAtomicPointer<QList<int> > d_hexes;
+  mutable QAtomicPointer<QList<double> > d_doubles;
+  mutable QAtomicPointer<QList<bool> > d_bools;
+  mutable QAtomicPointer<QList<QTime> > d_times;
+  mutable QAtomicPointer<QList<QHostAddress> > d_addresses;
+  Retired *d_retired;
+};
+
+
+#endif  // PROFILEVALUES_H
@@ -0,0 +1,382 @@
+// profilewatcher.cpp
+//
+// Incrementally reload a Profile from watched directories.
+//
+// (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of version 2.1 of the GNU Lesser General Public
+//    License as published by the Free Software Foundation;
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330,
+//    Boston, MA  02111-1307  USA
+//
+// EXEMPLAR_VERSION: 2.0.2
+//
+
+#include <errno.h>
+#include <string.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <QDir>
+
+#include "profilewatcher.h"
+
+#define __PROFILEWATCHER_EVENTS IN_ATTRIB|IN_CLOSE_WRITE|IN_CREATE|IN_DELETE|\
+    IN_DELETE_SELF|IN_MODIFY|IN_MOVE_SELF|IN_MOVED_FROM|IN_MOVED_TO
+
+ProfileWatcher::ProfileWatcher(bool use_section_ids,QObject *parent)
+  : QObject(parent)
+{
+  d_profile=new Profile(use_section_ids);
+  d_inotify_notifier=NULL;
+
+  d_debounce_timer=new QTimer(this);
+  d_debounce_timer->setSingleShot(true);
+  d_debounce_timer->setInterval(PROFILEWATCHER_DEFAULT_DEBOUNCE_INTERVAL);
+  connect(d_debounce_timer,SIGNAL(timeout()),this,SLOT(debounceData()));
+
+  d_rewatch_timer=new QTimer(this);
+  d_rewatch_timer->setInterval(PROFILEWATCHER_REWATCH_INTERVAL);
+  connect(d_rewatch_timer,SIGNAL(timeout()),this,SLOT(debounceData()));
+
+  if((d_inotify_fd=inotify_init1(IN_NONBLOCK|IN_CLOEXEC))>=0) {
+    d_inotify_notifier=
+      new QSocketNotifier(d_inotify_fd,QSocketNotifier::Read,this);
+    connect(d_inotify_notifier,SIGNAL(activated(int)),
+	    this,SLOT(inotifyReadyData(int)));
+  }
+}
+
+
+ProfileWatcher::~ProfileWatcher()
+{
+  if(d_inotify_notifier!=NULL) {
+    delete d_inotify_notifier;
+  }
+  if(d_inotify_fd>=0) {
+    close(d_inotify_fd);
+  }
+  for(int i=0;i<d_directories.size();i++) {
+    delete d_directories.at(i);
+  }
+  delete d_profile;
+}
+
+
+const Profile *ProfileWatcher::profile() const
+{
+  return d_profile;
+}
+
+
+int ProfileWatcher::debounceInterval() const
+{
+  return d_debounce_timer->interval();
+}
+
+
+void ProfileWatcher::setDebounceInterval(int msecs)
+{
+  d_debounce_timer->setInterval(msecs);
+}
+
+
+int ProfileWatcher::watchDirectory(const QString &dirpath,
+				   const QString &glob_template,
+				   QStringList *err_msgs)
+{
+  Directory *d=new Directory();
+  int ret=0;
+
+  if(!Profile::ListDirectory(dirpath,glob_template,&d->path,&d->filenames,
+			     err_msgs)) {
+    delete d;
+    return -1;
+  }
+  if(d_inotify_fd<0) {
+    if(err_msgs!=NULL) {
+      err_msgs->push_back(QObject::tr("unable to initialize inotify"));
+    }
+    delete d;
+    return -1;
+  }
+
+  //
+  // Start watching before the first read, so that nothing written in
+  // between can be missed
+  //
+  d->glob_template=glob_template;
+  if((d->wd=inotify_add_watch(d_inotify_fd,d->path.toUtf8().constData(),
+			      __PROFILEWATCHER_EVENTS))<0) {
+    if(err_msgs!=NULL) {
+      err_msgs->push_back(QString::asprintf("unable to watch directory: %s",
+					    strerror(errno)));
+    }
+    delete d;
+    return -1;
+  }
+  d_directories.push_back(d);
+  d->filenames=ListFiles(d);  // List again, now that the watch is in place
+
+  QSet<QString> sections;
+  for(int i=0;i<d->filenames.size();i++) {
+    QString err_msg;
+    bool loaded=LoadFile(d,d->filenames.at(i),&sections,&err_msg);
+    if(loaded) {
+      ret++;
+    }
+    if(err_msgs!=NULL) {
+      err_msgs->push_back(Profile::LoadMessage(d->path,d->filenames.at(i),
+					       loaded,err_msg));
+    }
+  }
+  UpdateSource(d);
+  d_profile->RebuildSections(Sources(),sections);
+
+  return ret;
+}
+
+
+void ProfileWatcher::inotifyReadyData(int fd)
+{
+  char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+  const struct inotify_event *event=NULL;
+  bool relevant=false;
+  ssize_t n;
+
+  while((n=read(fd,buffer,sizeof(buffer)))>0) {
+    for(char *ptr=buffer;ptr<(buffer+n);
+	ptr+=sizeof(struct inotify_event)+event->len) {
+      event=(const struct inotify_event *)ptr;
+      if((event->mask&IN_Q_OVERFLOW)!=0) {
+	//
+	// Events were lost, so check every file
+	//
+	for(int i=0;i<d_directories.size();i++) {
+	  for(int j=0;j<d_directories.at(i)->filenames.size();j++) {
+	    d_directories.at(i)->
+	      pending.insert(d_directories.at(i)->filenames.at(j));
+	  }
+	}
+	relevant=true;
+	continue;
+      }
+      if((event->mask&(IN_DELETE_SELF|IN_MOVE_SELF|IN_IGNORED))!=0) {
+	//
+	// The directory itself is gone (or no longer at its path), so its
+	// files are rechecked and the watch re-added once it comes back
+	//
+	for(int i=0;i<d_directories.size();i++) {
+	  Directory *d=d_directories.at(i);
+	  if(d->wd==event->wd) {
+	    if((event->mask&IN_MOVE_SELF)!=0) {
+	      inotify_rm_watch(d_inotify_fd,d->wd);
+	    }
+	    d->wd=-1;
+	    for(int j=0;j<d->filenames.size();j++) {
+	      d->pending.insert(d->filenames.at(j));
+	    }
+	    relevant=true;
+	  }
+	}
+	continue;
+      }
+      if(event->len==0) {
+	continue;
+      }
+      for(int i=0;i<d_directories.size();i++) {
+	Directory *d=d_directories.at(i);
+	if(d->wd==event->wd) {
+	  QString name=QString::fromUtf8(event->name);
+	  if(QDir::match(d->glob_template,name)) {
+	    d->pending.insert(name);
+	    relevant=true;
+	  }
+	}
+      }
+    }
+  }
+
+  //
+  // Trailing debounce, but a continuous stream of writes cannot hold off
+  // a reload forever
+  //
+  if(relevant) {
+    int limit=PROFILEWATCHER_MAX_DEBOUNCE_FACTOR*d_debounce_timer->interval();
+    if(!d_debounce_timer->isActive()) {
+      d_burst_clock.start();
+      d_debounce_timer->start();
+    }
+    else {
+      if(d_burst_clock.elapsed()<limit) {
+	d_debounce_timer->start();
+      }
+    }
+  }
+}
+
+
+void ProfileWatcher::debounceData()
+{
+  QSet<QString> sections;
+
+  for(int i=0;i<d_directories.size();i++) {
+    Directory *d=d_directories.at(i);
+    if(d->wd<0) {
+      d->wd=inotify_add_watch(d_inotify_fd,d->path.toUtf8().constData(),
+			      __PROFILEWATCHER_EVENTS);
+    }
+    QStringList filenames=ListFiles(d);
+    QSet<QString> present;
+    for(int j=0;j<filenames.size();j++) {
+      present.insert(filenames.at(j));
+    }
+    bool updated=false;
+
+    //
+    // Deleted files
+    //
+    for(int j=0;j<d->filenames.size();j++) {
+      if(!present.contains(d->filenames.at(j))) {
+	RemoveFile(d,d->filenames.at(j),&sections);
+	updated=true;
+      }
+    }
+
+    //
+    // New and changed files
+    //
+    for(int j=0;j<filenames.size();j++) {
+      QMap<QString,Profile::SourceFile>::const_iterator it=
+	d->stats.constFind(filenames.at(j));
+      Profile::SourceFile src;
+      Profile::StatFile(d->path+"/"+filenames.at(j),&src);
+      if((it==d->stats.constEnd())||d->pending.contains(filenames.at(j))||
+	 (it.value().size!=src.size)||(it.value().mtime!=src.mtime)) {
+	LoadFile(d,filenames.at(j),&sections,NULL);
+	updated=true;
+      }
+    }
+    d->filenames=filenames;
+    d->pending.clear();
+    if(updated) {
+      UpdateSource(d);
+    }
+  }
+
+  //
+  // Poll for unwatched directories to reappear
+  //
+  bool unwatched=false;
+  for(int i=0;i<d_directories.size();i++) {
+    unwatched=unwatched||(d_directories.at(i)->wd<0);
+  }
+  if(unwatched) {
+    if(!d_rewatch_timer->isActive()) {
+      d_rewatch_timer->start();
+    }
+  }
+  else {
+    d_rewatch_timer->stop();
+  }
+
+  if(!sections.isEmpty()) {
+    d_profile->RebuildSections(Sources(),sections);
+    QStringList names=sections.values();
+    names.sort();
+    emit changed(names);
+  }
+}
+
+
+//
+// A directory that cannot be listed (e.g. because it has been removed)
+// contributes no files
+//
+QStringList ProfileWatcher::ListFiles(Directory *dir) const
+{
+  QString path;
+  QStringList filenames;
+
+  if(!Profile::ListDirectory(dir->path,dir->glob_template,&path,&filenames,
+			     NULL)) {
+    filenames.clear();
+  }
+
+  return filenames;
+}
+
+
+bool ProfileWatcher::LoadFile(Directory *dir,const QString &filename,
+			      QSet<QString> *sections,QString *err_msg)
+{
+  Profile::BlockList blocks;
+  Profile::SourceFile src;
+
+  RemoveFile(dir,filename,sections);
+  bool ret=Profile::ReadFile(dir->path+"/"+filename,&blocks,err_msg,&src);
+  for(int i=0;i<blocks.size();i++) {
+    sections->insert(blocks.at(i).first);
+  }
+  dir->blocks[filename]=blocks;
+  dir->stats[filename]=src;
+
+  return ret;
+}
+
+
+void ProfileWatcher::RemoveFile(Directory *dir,const QString &filename,
+				QSet<QString> *sections)
+{
+  QMap<QString,Profile::BlockList>::const_iterator it=
+    dir->blocks.constFind(filename);
+  if(it!=dir->blocks.constEnd()) {
+    for(int i=0;i<it.value().size();i++) {
+      sections->insert(it.value().at(i).first);
+    }
+  }
+  dir->blocks.remove(filename);
+  dir->stats.remove(filename);
+}
+
+
+void ProfileWatcher::UpdateSource(Directory *dir)
+{
+  QList<Profile::SourceFile> files;
+
+  for(int i=0;i<dir->filenames.size();i++) {
+    files.push_back(dir->stats.value(dir->filenames.at(i)));
+  }
+  d_profile->SetSource(dir->path,dir->glob_template,files);
+}
+
+
+//
+// Every watched file, in the order a full load would have merged them
+//
+QList<const Profile::BlockList *> ProfileWatcher::Sources() const
+{
+  QList<const Profile::BlockList *> ret;
+
+  for(int i=0;i<d_directories.size();i++) {
+    const Directory *d=d_directories.at(i);
+    for(int j=0;j<d->filenames.size();j++) {
+      QMap<QString,Profile::BlockList>::const_iterator it=
+	d->blocks.constFind(d->filenames.at(j));
+      if(it!=d->blocks.constEnd()) {
+	ret.push_back(&it.value());
+      }
+    }
+  }
+
+  return ret;
+}
@@ -0,0 +1,89 @@
+// profilewatcher.h
+//
+// Incrementally reload a Profile from watched directories.
+//
+// (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of version 2.1 of the GNU Lesser General Public
+//    License as published by the Free Software Foundation;
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330,
+//    Boston, MA  02111-1307  USA
+//
+// EXEMPLAR_VERSION: 2.0.2
+//
+
+#ifndef PROFILEWATCHER_H
+#define PROFILEWATCHER_H
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QMap>
+#include <QObject>
+#include <QSet>
+#include <QSocketNotifier>
+#include <QStringList>
+#include <QTimer>
+
+#include "profile.h"
+
+#define PROFILEWATCHER_DEFAULT_DEBOUNCE_INTERVAL 100
+#define PROFILEWATCHER_MAX_DEBOUNCE_FACTOR 10
+#define PROFILEWATCHER_REWATCH_INTERVAL 1000
+
+class ProfileWatcher : public QObject
+{
+  Q_OBJECT
+ public:
+  ProfileWatcher(bool use_section_ids=false,QObject *parent=0);
+  ~ProfileWatcher();
+  const Profile *profile() const;
+  int debounceInterval() const;
+  void setDebounceInterval(int msecs);
+  int watchDirectory(const QString &dirpath,const QString &glob_template,
+		     QStringList *err_msgs=NULL);
+
+ signals:
+  void changed(const QStringList &sections);
+
+ private slots:
+  void inotifyReadyData(int fd);
+  void debounceData();
+
+ private:
+  struct Directory
+  {
+    QString path;
+    QString glob_template;
+    int wd;
+    QStringList filenames;
+    QMap<QString,Profile::BlockList> blocks;
+    QMap<QString,Profile::SourceFile> stats;
+    QSet<QString> pending;
+  };
+  QStringList ListFiles(Directory *dir) const;
+  bool LoadFile(Directory *dir,const QString &filename,
+		QSet<QString> *sections,QString *err_msg);
+  void RemoveFile(Directory *dir,const QString &filename,
+		  QSet<QString> *sections);
+  void UpdateSource(Directory *dir);
+  QList<const Profile::BlockList *> Sources() const;
+  Profile *d_profile;
+  QList<Directory *> d_directories;
+  int d_inotify_fd;
+  QSocketNotifier *d_inotify_notifier;
+  QTimer *d_debounce_timer;
+  QTimer *d_rewatch_timer;
+  QElapsedTimer d_burst_clock;
+};
+
+
+#endif  // PROFILEWATCHER_H
@@ -0,0 +1,235 @@
+// sharedprofile.cpp
+//
+// Publish Profile snapshots to concurrent readers.
+//
+// (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of version 2.1 of the GNU Lesser General Public
+//    License as published by the Free Software Foundation;
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330,
+//    Boston, MA  02111-1307  USA
+//
+// EXEMPLAR_VERSION: 2.0.2
+//
+
+#include <atomic>
+
+#include <QAtomicInteger>
+#include <QList>
+#include <QMutexLocker>
+#include <QThread>
+
+#include "sharedprofile.h"
+
+//
+// Snapshots are reclaimed with a userspace RCU scheme. Each reading thread
+// owns a Reader slot holding the grace period epoch it entered its read
+// section in, or zero when it is outside one. Publishing swaps in the new
+// snapshot, opens a new epoch, and then waits for every slot to be either
+// idle or in the new epoch before deleting the old snapshot. Readers never
+// wait on a publisher; the registry lock is only taken, briefly, when a
+// thread first reads and when it exits. Opening an outermost read section
+// costs a thread local lookup, a store to the slot, a full fence and the
+// snapshot load; nested ones cost only the snapshot load.
+//
+// Slots are recycled rather than freed when their thread exits, so a
+// publisher can wait on a copy of the registry without holding its lock.
+//
+class SharedProfile::Reader
+{
+ public:
+  Reader();
+  QAtomicInteger<quint64> epoch;
+  int depth;
+  bool active;
+};
+
+
+static QAtomicInteger<quint64> __sharedprofile_epoch(1);
+
+QMutex *SharedProfile::RegistryMutex()
+{
+  static QMutex mutex;
+
+  return &mutex;
+}
+
+
+QList<SharedProfile::Reader *> *SharedProfile::Registry()
+{
+  static QList<Reader *> readers;
+
+  return &readers;
+}
+
+
+SharedProfile::Reader::Reader()
+  : epoch(0)
+{
+  depth=0;
+  active=false;
+}
+
+
+SharedProfile::Reader *SharedProfile::ThisReader()
+{
+  class Slot
+  {
+   public:
+    Slot()
+    {
+      QMutexLocker locker(RegistryMutex());
+      QList<Reader *> *readers=Registry();
+      reader=NULL;
+      for(int i=0;i<readers->size();i++) {
+	if(!readers->at(i)->active) {
+	  reader=readers->at(i);
+	  break;
+	}
+      }
+      if(reader==NULL) {
+	reader=new Reader();
+	readers->push_back(reader);
+      }
+      reader->active=true;
+    }
+    ~Slot()
+    {
+      QMutexLocker locker(RegistryMutex());
+      reader->active=false;
+    }
+    Reader *reader;
+  };
+  static thread_local Slot slot;
+
+  return slot.reader;
+}
+
+
+SharedProfile::ReadLock::ReadLock(const SharedProfile *shared)
+{
+  d_reader=ThisReader();
+  if(d_reader->depth++==0) {
+    //
+    // A full fence, paired with the one in Synchronize(), so the snapshot
+    // load below cannot be ordered ahead of the slot becoming visible to
+    // a publisher
+    //
+    d_reader->epoch.storeRelaxed(__sharedprofile_epoch.loadAcquire());
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+  }
+  d_profile=shared->d_current.loadAcquire();
+}
+
+
+SharedProfile::ReadLock::~ReadLock()
+{
+  if(--d_reader->depth==0) {
+    d_reader->epoch.storeRelease(0);
+  }
+}
+
+
+const Profile *SharedProfile::ReadLock::profile() const
+{
+  return d_profile;
+}
+
+
+const Profile *SharedProfile::ReadLock::operator->() const
+{
+  return d_profile;
+}
+
+
+SharedProfile::SharedProfile(bool use_section_ids)
+{
+  d_use_section_ids=use_section_ids;
+  d_current.storeRelease(new Profile(use_section_ids));
+}
+
+
+SharedProfile::~SharedProfile()
+{
+  delete d_current.loadAcquire();
+}
+
+
+bool SharedProfile::useSectionIds() const
+{
+  return d_use_section_ids;
+}
+
+
+//
+// Publishing waits for every read section to finish, so doing it from
+// inside one would wait forever on the caller's own slot.
+//
+bool SharedProfile::publish(Profile *p)
+{
+  if(ThisReader()->depth!=0) {
+    return false;
+  }
+  QMutexLocker locker(&d_publish_mutex);
+
+  const Profile *old=d_current.fetchAndStoreOrdered(p);
+  Synchronize();
+  delete old;
+
+  return true;
+}
+
+
+//
+// A reload that loses any of its files would hand every reader a partial
+// or empty profile, so the current snapshot is kept unless all of them
+// loaded. Profile::load() reports exactly one message for each file it
+// tried, which is what tells a partial load apart from a complete one.
+//
+int SharedProfile::load(const QString &glob_path,QStringList *err_msgs)
+{
+  Profile *p=new Profile(d_use_section_ids);
+  QStringList msgs;
+  int ret=p->load(glob_path,&msgs);
+  if(err_msgs!=NULL) {
+    *err_msgs+=msgs;
+  }
+  if((ret<=0)||(ret!=msgs.size())||(!publish(p))) {
+    delete p;
+    return -1;
+  }
+
+  return ret;
+}
+
+
+void SharedProfile::Synchronize()
+{
+  quint64 epoch=__sharedprofile_epoch.fetchAndAddOrdered(1)+1;
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+
+  //
+  // Slots registered after the copy is taken can only see the new epoch
+  // and snapshot, so they need no waiting for
+  //
+  QList<Reader *> readers;
+  RegistryMutex()->lock();
+  readers=*Registry();
+  RegistryMutex()->unlock();
+
+  for(int i=0;i<readers.size();i++) {
+    quint64 e=0;
+    while(((e=readers.at(i)->epoch.loadAcquire())!=0)&&(e<epoch)) {
+      QThread::yieldCurrentThread();
+    }
+  }
+}
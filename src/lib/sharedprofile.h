@@ -0,0 +1,82 @@
+// sharedprofile.h
+//
+// Publish Profile snapshots to concurrent readers.
+//
+// (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of version 2.1 of the GNU Lesser General Public
+//    License as published by the Free Software Foundation;
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330,
+//    Boston, MA  02111-1307  USA
+//
+// EXEMPLAR_VERSION: 2.0.2
+//
+
+#ifndef SHAREDPROFILE_H
+#define SHAREDPROFILE_H
+
+#include <QAtomicPointer>
+#include <QList>
+#include <QMutex>
+#include <QStringList>
+
+#include "profile.h"
+
+//
+// A Profile that can be replaced while other threads read it. Readers
+// hold a ReadLock for as long as they use the snapshot it returns; taking
+// one never blocks, but the outermost one in a thread does a store and a
+// full memory fence as well as the snapshot load. publish() and load()
+// block until every read section open at the time has closed, and so
+// fail, returning false or -1, when called from inside a read section.
+// A Profile that publish() refuses is still owned by the caller.
+//
+class SharedProfile
+{
+ private:
+  class Reader;
+
+ public:
+  class ReadLock
+  {
+   public:
+    ReadLock(const SharedProfile *shared);
+    ~ReadLock();
+    const Profile *profile() const;
+    const Profile *operator->() const;
+
+   private:
+    ReadLock(const ReadLock &);
+    ReadLock &operator=(const ReadLock &);
+    Reader *d_reader;
+    const Profile *d_profile;
+  };
+  SharedProfile(bool use_section_ids=false);
+  ~SharedProfile();
+  bool useSectionIds() const;
+  bool publish(Profile *p);
+  int load(const QString &glob_path,QStringList *err_msgs);
+
+ private:
+  SharedProfile(const SharedProfile &);
+  SharedProfile &operator=(const SharedProfile &);
+  static Reader *ThisReader();
+  static QList<Reader *> *Registry();
+  static QMutex *RegistryMutex();
+  static void Synchronize();
+  QAtomicPointer<const Profile> d_current;
+  QMutex d_publish_mutex;
+  bool d_use_section_ids;
+};
+
+
+#endif  // SHAREDPROFILE_H
@@ -0,0 +1,787 @@
+// bench_profile.cpp
+//
+// Benchmarks for the Profile configurator class.
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#include <malloc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <utility>
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QMap>
+#include <QStringList>
+#include <QTemporaryDir>
+#include <QTemporaryFile>
+#include <QVector>
+
+#include <cmdswitch.h>
+#include <profile.h>
+#include <profilebinding.h>
+#include <profilescanner.h>
+
+#include "bench_profile.h"
+
+static int __BenchProfile_Count(const QString &name,const QString &value,
+				int min)
+{
+  bool ok=false;
+  int ret=value.toInt(&ok);
+
+  if((!ok)||(ret<min)) {
+    fprintf(stderr,"bench_profile: invalid %s value\n",
+	    name.toUtf8().constData());
+    exit(1);
+  }
+  return ret;
+}
+
+
+MainObject::MainObject()
+  : QObject()
+{
+  QString test;
+  int size=16;
+  int passes=5;
+  bool ok=false;
+
+  d_sections=BENCH_PROFILE_DEFAULT_SECTIONS;
+  d_tags=BENCH_PROFILE_DEFAULT_TAGS;
+  d_repeats=1;
+  d_files=1;
+  d_lookups=BENCH_PROFILE_DEFAULT_LOOKUPS;
+  d_section_ids=false;
+
+  CmdSwitch *cmd=new CmdSwitch("bench_profile",VERSION,BENCH_PROFILE_USAGE);
+  for(int i=0;i<cmd->keys();i++) {
+    if(cmd->key(i)=="--files") {
+      d_files=__BenchProfile_Count(cmd->key(i),cmd->value(i),1);
+      cmd->setProcessed(i,true);
+    }
+    if(cmd->key(i)=="--lookups") {
+      d_lookups=__BenchProfile_Count(cmd->key(i),cmd->value(i),1);
+      cmd->setProcessed(i,true);
+    }
+    if(cmd->key(i)=="--passes") {
+      passes=cmd->value(i).toInt(&ok);
+      if((!ok)||(passes<1)) {
+	fprintf(stderr,"bench_profile: invalid --passes value\n");
+	exit(1);
+      }
+      cmd->setProcessed(i,true);
+    }
+    if(cmd->key(i)=="--repeats") {
+      d_repeats=__BenchProfile_Count(cmd->key(i),cmd->value(i),1);
+      cmd->setProcessed(i,true);
+    }
+    if(cmd->key(i)=="--results") {
+      d_results=cmd->value(i).trimmed();
+      cmd->setProcessed(i,true);
+    }
+    if(cmd->key(i)=="--section-ids") {
+      d_section_ids=true;
+      cmd->setProcessed(i,true);
+    }
+    if(cmd->key(i)=="--sections") {
+      d_sections=__BenchProfile_Count(cmd->key(i),cmd->value(i),1);
+      cmd->setProcessed(i,true);
+    }
+    if(cmd->key(i)=="--size") {
+      size=cmd->value(i).toInt(&ok);
+      if((!ok)||(size<1)) {
+	fprintf(stderr,"bench_profile: invalid --size value\n");
+	exit(1);
+      }
+      cmd->setProcessed(i,true);
+    }
+    if(cmd->key(i)=="--tags") {
+      d_tags=__BenchProfile_Count(cmd->key(i),cmd->value(i),1);
+      cmd->setProcessed(i,true);
+    }
+    if(cmd->key(i)=="--test") {
+      test=cmd->value(i).trimmed();
+      cmd->setProcessed(i,true);
+    }
+    if(!cmd->processed(i)) {
+      fprintf(stderr,"bench_profile: unrecognized option \"%s\"\n",
+	      cmd->key(i).toUtf8().constData());
+      exit(1);
+    }
+  }
+  if(test.isEmpty()) {
+    fprintf(stderr,"bench_profile: you must specify a --test\n");
+    exit(1);
+  }
+
+  if(test=="scanner") {
+    d_data=GenerateData(size*1048576);
+    RunScannerBenchmark(passes);
+  }
+  else if(test=="binding") {
+    RunBindingBenchmark(passes);
+  }
+  else if(test=="memory") {
+    d_data=GenerateData(size*1048576);
+    RunMemoryBenchmark();
+  }
+  else if(test=="profile") {
+    RunProfileBenchmark(passes);
+  }
+  else {
+    fprintf(stderr,"bench_profile: unknown test \"%s\"\n",
+	    test.toUtf8().constData());
+    exit(1);
+  }
+
+  exit(0);
+}
+
+
+void MainObject::RunScannerBenchmark(int passes)
+{
+  QElapsedTimer timer;
+  qint64 best=0;
+
+  printf("**** Scanner Benchmark (%d bytes, best of %d) ****\n",
+	 d_data.size(),passes);
+
+  //
+  // Baseline: the line list that 'Profile::addSource()' consumes
+  //
+  QStringList lines;
+  best=0;
+  for(int i=0;i<passes;i++) {
+    timer.start();
+    lines=QString::fromUtf8(d_data).split("\n",Qt::KeepEmptyParts);
+    for(int j=0;j<lines.size();j++) {
+      lines[j]=lines.at(j).trimmed();
+    }
+    qint64 nsecs=timer.nsecsElapsed();
+    if((best==0)||(nsecs<best)) {
+      best=nsecs;
+    }
+  }
+  printf("  %24s: %10.1lf MB/s\n","line splitting",Rate(d_data.size(),best));
+  best=0;
+  for(int i=0;i<passes;i++) {
+    Profile *p=new Profile();
+    timer.start();
+    p->addSource(lines);
+    qint64 nsecs=timer.nsecsElapsed();
+    if((best==0)||(nsecs<best)) {
+      best=nsecs;
+    }
+    delete p;
+  }
+  printf("  %24s: %10.1lf MB/s\n","addSource()",Rate(d_data.size(),best));
+  best=0;
+  for(int i=0;i<passes;i++) {
+    QStringList consumed=lines;
+    Profile *p=new Profile();
+    timer.start();
+    p->addSource(std::move(consumed));
+    qint64 nsecs=timer.nsecsElapsed();
+    if((best==0)||(nsecs<best)) {
+      best=nsecs;
+    }
+    delete p;
+  }
+  printf("  %24s: %10.1lf MB/s\n","addSource(&&)",Rate(d_data.size(),best));
+
+  //
+  // Scanner kernels by themselves
+  //
+  ProfileScanner::Kernel active=ProfileScanner::kernel();
+  for(int k=ProfileScanner::Scalar;k<=ProfileScanner::Avx2;k++) {
+    if(!ProfileScanner::setKernel((ProfileScanner::Kernel)k)) {
+      continue;
+    }
+    best=0;
+    for(int i=0;i<passes;i++) {
+      int count=0;
+      timer.start();
+      ProfileScanner scanner(d_data.constData(),d_data.size());
+      while(scanner.nextLine()) {
+	count+=scanner.lineType();
+      }
+      qint64 nsecs=timer.nsecsElapsed();
+      if((best==0)||(nsecs<best)) {
+	best=nsecs;
+      }
+      if(count==0) {
+	fprintf(stderr,"bench_profile: scanner found no lines\n");
+	exit(1);
+      }
+    }
+    printf("  %24s: %10.1lf MB/s\n",
+	   ("scanner ("+ProfileScanner::kernelText((ProfileScanner::Kernel)k)+
+	    ")").toUtf8().constData(),Rate(d_data.size(),best));
+  }
+  ProfileScanner::setKernel(active);
+
+  //
+  // The complete file load path
+  //
+  QTemporaryFile file;
+  if((!file.open())||(file.write(d_data)!=d_data.size())||(!file.flush())) {
+    fprintf(stderr,"bench_profile: unable to write temporary file\n");
+    exit(1);
+  }
+  best=0;
+  for(int i=0;i<passes;i++) {
+    Profile *p=new Profile();
+    timer.start();
+    p->loadFile(file.fileName());
+    qint64 nsecs=timer.nsecsElapsed();
+    if((best==0)||(nsecs<best)) {
+      best=nsecs;
+    }
+    delete p;
+  }
+  printf("  %24s: %10.1lf MB/s\n",
+	 ("loadFile() ("+ProfileScanner::kernelText(active)+")").
+	 toUtf8().constData(),Rate(d_data.size(),best));
+  best=0;
+  for(int i=0;i<passes;i++) {
+    Profile *p=new Profile();
+    timer.start();
+    p->loadData(d_data);
+    qint64 nsecs=timer.nsecsElapsed();
+    if((best==0)||(nsecs<best)) {
+      best=nsecs;
+    }
+    delete p;
+  }
+  printf("  %24s: %10.1lf MB/s\n",
+	 ("loadData() ("+ProfileScanner::kernelText(active)+")").
+	 toUtf8().constData(),Rate(d_data.size(),best));
+}
+
+
+void MainObject::RunBindingBenchmark(int passes)
+{
+  static const ProfileBinding<BenchSettings> binding=
+    ProfileBinding<BenchSettings>().
+    bind("Server","Hostname",&BenchSettings::hostname,"localhost").
+    bind("Server","Port",&BenchSettings::port,8080).
+    bind("Server","Address",&BenchSettings::address).
+    bind("Server","Enabled",&BenchSettings::enabled).
+    bind("Server","StartTime",&BenchSettings::start_time).
+    bind("Audio","Card",&BenchSettings::card).
+    bind("Audio","SampleRate",&BenchSettings::rate,48000).
+    bind("Audio","Gain",&BenchSettings::gain,1.0).
+    bindHex("Audio","ChannelMask",&BenchSettings::mask).
+    bind("Audio","Channel",&BenchSettings::channels);
+  QElapsedTimer timer;
+  qint64 best=0;
+  BenchSettings settings;
+
+  QStringList lines;
+  lines.push_back("[Server]");
+  lines.push_back("Hostname=studio.example.com");
+  lines.push_back("Port=5005");
+  lines.push_back("Address=192.168.10.30");
+  lines.push_back("Enabled=Yes");
+  lines.push_back("StartTime=06:00:00");
+  lines.push_back("[Audio]");
+  lines.push_back("Card=hw:0");
+  lines.push_back("SampleRate=44100");
+  lines.push_back("Gain=0.75");
+  lines.push_back("ChannelMask=0x00FF");
+  for(int i=0;i<16;i++) {
+    lines.push_back(QString::asprintf("Channel=%d",i+1));
+  }
+  Profile *p=new Profile();
+  p->addSource(lines);
+
+  printf("**** Binding Benchmark (%d fields, %d reads, best of %d) ****\n",
+	 binding.fieldCount(),BENCH_PROFILE_BINDING_READS,passes);
+
+  //
+  // Individual getter calls
+  //
+  for(int i=0;i<passes;i++) {
+    timer.start();
+    for(int j=0;j<BENCH_PROFILE_BINDING_READS;j++) {
+      settings.hostname=p->stringValue("Server","Hostname","localhost");
+      settings.port=p->intValue("Server","Port",8080);
+      settings.address=p->addressValue("Server","Address",QHostAddress());
+      settings.enabled=p->boolValue("Server","Enabled");
+      settings.start_time=p->timeValue("Server","StartTime");
+      settings.card=p->stringValue("Audio","Card");
+      settings.rate=p->intValue("Audio","SampleRate",48000);
+      settings.gain=p->doubleValue("Audio","Gain",1.0);
+      settings.mask=p->hexValue("Audio","ChannelMask");
+      settings.channels=p->intValues("Audio","Channel");
+    }
+    qint64 nsecs=timer.nsecsElapsed();
+    if((best==0)||(nsecs<best)) {
+      best=nsecs;
+    }
+  }
+  printf("  %24s: %10.1lf ns/struct\n","individual getters",
+	 (double)best/(double)BENCH_PROFILE_BINDING_READS);
+
+  //
+  // The same fields through a binding
+  //
+  best=0;
+  for(int i=0;i<passes;i++) {
+    timer.start();
+    for(int j=0;j<BENCH_PROFILE_BINDING_READS;j++) {
+      binding.read(p,&settings);
+    }
+    qint64 nsecs=timer.nsecsElapsed();
+    if((best==0)||(nsecs<best)) {
+      best=nsecs;
+    }
+  }
+  printf("  %24s: %10.1lf ns/struct\n","ProfileBinding::read()",
+	 (double)best/(double)BENCH_PROFILE_BINDING_READS);
+
+  delete p;
+}
+
+
+void MainObject::RunMemoryBenchmark()
+{
+  QStringList fixtures;
+  fixtures.push_back("../../fixtures/legacy.conf");
+  fixtures.push_back("../../fixtures/extended.conf");
+  fixtures.push_back("../../fixtures/extended_all.conf");
+
+  printf("**** Memory Benchmark (heap bytes held after load) ****\n");
+  printf("  %24s  %10s  %10s  %10s  %6s  %10s\n",
+	 "source","file","utf-16","compact","ratio","read");
+  for(int i=0;i<fixtures.size();i++) {
+    QFile file(fixtures.at(i));
+    if(!file.open(QIODevice::ReadOnly)) {
+      fprintf(stderr,"bench_profile: unable to open \"%s\"\n",
+	      fixtures.at(i).toUtf8().constData());
+      exit(1);
+    }
+    MeasureMemory(fixtures.at(i).split("/").last(),file.readAll());
+  }
+  MeasureMemory(QString::asprintf("synthetic (%d MB)",d_data.size()/1048576),
+		d_data);
+}
+
+
+void MainObject::MeasureMemory(const QString &label,
+			       const QByteArray &data) const
+{
+  QTemporaryFile file;
+  if((!file.open())||(file.write(data)!=data.size())||(!file.flush())) {
+    fprintf(stderr,"bench_profile: unable to write temporary file\n");
+    exit(1);
+  }
+
+  //
+  // Baseline: every name and value held as a separate UTF-16 QString
+  //
+  qint64 before=HeapBytes();
+  QMap<QString,QMap<QString,QStringList> > *utf16=
+    new QMap<QString,QMap<QString,QStringList> >();
+  QMap<QString,QStringList> *section=NULL;
+  ProfileScanner scanner(data.constData(),data.size());
+  while(scanner.nextLine()) {
+    switch(scanner.lineType()) {
+    case ProfileScanner::Section:
+      section=&(*utf16)[QString::fromUtf8(scanner.lineStart()+1,
+					  scanner.lineLength()-2)];
+      break;
+
+    case ProfileScanner::Value:
+      if((section!=NULL)&&(scanner.separator()!=NULL)) {
+	(*section)[QString::fromUtf8(scanner.lineStart(),
+			     scanner.separator()-scanner.lineStart())].
+	  push_back(QString::fromUtf8(scanner.separator()+1,
+			      scanner.lineEnd()-scanner.separator()-1));
+      }
+      break;
+
+    default:
+      break;
+    }
+  }
+  qint64 utf16_bytes=HeapBytes()-before;
+  delete utf16;
+
+  //
+  // Profile's compact storage
+  //
+  before=HeapBytes();
+  Profile *p=new Profile();
+  p->loadFile(file.fileName());
+  qint64 compact_bytes=HeapBytes()-before;
+
+  //
+  // ...and after every value has been read back as a string, which must
+  // not leave decoded copies behind
+  //
+  QString section_name;
+  ProfileScanner reader(data.constData(),data.size());
+  while(reader.nextLine()) {
+    if(reader.lineType()==ProfileScanner::Section) {
+      section_name=QString::fromUtf8(reader.lineStart()+1,
+				     reader.lineLength()-2);
+    }
+    if((reader.lineType()==ProfileScanner::Value)&&
+       (reader.separator()!=NULL)) {
+      QString tag=QString::fromUtf8(reader.lineStart(),
+				    reader.separator()-reader.lineStart());
+      p->stringValue(section_name,tag);
+      p->stringValues(section_name,tag);
+    }
+  }
+  qint64 read_bytes=HeapBytes()-before;
+  delete p;
+
+  printf("  %24s  %10d  %10lld  %10lld  %5.2lfx  %10lld\n",
+	 label.toUtf8().constData(),data.size(),utf16_bytes,compact_bytes,
+	 (compact_bytes>0)?(double)utf16_bytes/(double)compact_bytes:0.0,
+	 read_bytes);
+}
+
+
+qint64 MainObject::HeapBytes() const
+{
+#if defined(__GLIBC__)&&((__GLIBC__>2)||(__GLIBC_MINOR__>=33))
+  struct mallinfo2 info=mallinfo2();
+#else
+  struct mallinfo info=mallinfo();
+#endif  // __GLIBC__
+  return (qint64)info.uordblks+(qint64)info.hblkhd;
+}
+
+
+//
+// Lookup latencies are timed one call at a time, so the figures include
+// the cost of reading the clock. Sections and tags are picked by a fixed
+// pseudo-random sequence so that runs can be compared.
+//
+void MainObject::RunProfileBenchmark(int passes)
+{
+  QElapsedTimer timer;
+  qint64 best=0;
+  QStringList results;
+
+  QTemporaryDir dir;
+  if(!dir.isValid()) {
+    fprintf(stderr,"bench_profile: unable to create temporary directory\n");
+    exit(1);
+  }
+  qint64 bytes=GenerateConfig(dir.path());
+
+  printf("**** Profile Benchmark (%d sections, %d tags, %d repeats, "
+	 "%d files%s, best of %d) ****\n",d_sections,d_tags,d_repeats,
+	 d_files,d_section_ids?", section IDs":"",passes);
+  results.push_back("[Benchmark]");
+  results.push_back(QString::asprintf("Sections=%d",d_sections));
+  results.push_back(QString::asprintf("Tags=%d",d_tags));
+  results.push_back(QString::asprintf("Repeats=%d",d_repeats));
+  results.push_back(QString::asprintf("Files=%d",d_files));
+  results.push_back(QString("SectionIds=")+(d_section_ids?"Yes":"No"));
+  results.push_back(QString::asprintf("Bytes=%lld",(long long)bytes));
+  results.push_back(QString::asprintf("Passes=%d",passes));
+  results.push_back("");
+
+  //
+  // Load
+  //
+  Profile *p=NULL;
+  for(int i=0;i<passes;i++) {
+    delete p;
+    p=new Profile(d_section_ids);
+    timer.start();
+    p->load(dir.path()+"/bench_*.conf",NULL);
+    qint64 nsecs=timer.nsecsElapsed();
+    if((best==0)||(nsecs<best)) {
+      best=nsecs;
+    }
+  }
+  printf("  %24s: %10.1lf MB/s (%.3lf ms)\n","load()",Rate(bytes,best),
+	 (double)best/1000000.0);
+  results.push_back("[Load]");
+  results.push_back(QString::asprintf("Nsecs=%lld",(long long)best));
+  results.push_back(QString::asprintf("MBytesPerSec=%.1lf",Rate(bytes,best)));
+  results.push_back("");
+
+  //
+  // Lookups
+  //
+  QVector<QString> sections(d_sections);
+  QVector<QString> ids(d_sections);
+  QVector<QString> tags(d_tags);
+  for(int i=0;i<d_sections;i++) {
+    sections[i]=SectionName(i);
+    ids[i]=QString::asprintf("%d",i);
+  }
+  for(int i=0;i<d_tags;i++) {
+    tags[i]=QString::asprintf("Tag%d",i);
+  }
+  QVector<int> picks(d_lookups);
+  quint32 seed=12345;
+  for(int i=0;i<d_lookups;i++) {
+    seed=seed*1103515245+12345;
+    picks[i]=(seed>>8)%d_sections;
+  }
+  const char *getters[]={"stringValue","intValue","doubleValue","boolValue",
+			 "stringValue(Key)","stringValue (miss)",NULL};
+  for(int g=0;getters[g]!=NULL;g++) {
+    QVector<Profile::Key> keys;
+    if(g==4) {
+      keys.resize(d_sections);
+      for(int i=0;i<d_sections;i++) {
+	keys[i]=d_section_ids?Profile::Key(sections.at(i),ids.at(i),tags.at(0)):
+	  Profile::Key(sections.at(i),tags.at(0));
+      }
+    }
+    QVector<qint64> latencies(d_lookups);
+    int found=0;
+    for(int i=0;i<d_lookups;i++) {
+      int s=picks.at(i);
+      const QString &tag=tags.at(i%d_tags);
+      timer.start();
+      switch(g) {
+      case 0:
+	found+=d_section_ids?
+	  p->stringValues(sections.at(s),ids.at(s),tag).size():
+	  !p->stringValue(sections.at(s),tag).isNull();
+	break;
+
+      case 1:
+	found+=d_section_ids?
+	  p->intValues(sections.at(s),ids.at(s),tag).size():
+	  p->intValue(sections.at(s),tag,-1);
+	break;
+
+      case 2:
+	found+=d_section_ids?
+	  p->doubleValues(sections.at(s),ids.at(s),tag).size():
+	  (int)p->doubleValue(sections.at(s),tag,-1.0);
+	break;
+
+      case 3:
+	found+=d_section_ids?
+	  p->boolValues(sections.at(s),ids.at(s),tag).size():
+	  p->boolValue(sections.at(s),tag);
+	break;
+
+      case 4:
+	found+=!p->stringValue(keys.at(s)).isNull();
+	break;
+
+      case 5:
+	found+=d_section_ids?
+	  p->stringValues(sections.at(s),ids.at(s),"NoSuchTag").size():
+	  p->stringValue(sections.at(s),"NoSuchTag","",NULL).size();
+	break;
+      }
+      latencies[i]=timer.nsecsElapsed();
+    }
+    std::sort(latencies.begin(),latencies.end());
+    printf("  %24s: p50=%lldns p90=%lldns p99=%lldns p99.9=%lldns%s\n",
+	   getters[g],(long long)Percentile(latencies,500),
+	   (long long)Percentile(latencies,900),
+	   (long long)Percentile(latencies,990),
+	   (long long)Percentile(latencies,999),(found==0)?" (no hits)":"");
+    results.push_back("[Lookup]");
+    results.push_back(QString("Id=")+getters[g]);
+    results.push_back(QString::asprintf("Calls=%d",d_lookups));
+    results.push_back(QString::asprintf("P50Nsecs=%lld",
+				(long long)Percentile(latencies,500)));
+    results.push_back(QString::asprintf("P90Nsecs=%lld",
+				(long long)Percentile(latencies,900)));
+    results.push_back(QString::asprintf("P99Nsecs=%lld",
+				(long long)Percentile(latencies,990)));
+    results.push_back(QString::asprintf("P999Nsecs=%lld",
+				(long long)Percentile(latencies,999)));
+    results.push_back("");
+  }
+
+  //
+  // Dump
+  //
+  best=0;
+  for(int i=0;i<passes;i++) {
+    timer.start();
+    QString dump=p->dump();
+    qint64 nsecs=timer.nsecsElapsed();
+    if((best==0)||(nsecs<best)) {
+      best=nsecs;
+    }
+  }
+  printf("  %24s: %10.3lf ms\n","dump()",(double)best/1000000.0);
+  results.push_back("[Dump]");
+  results.push_back(QString::asprintf("Nsecs=%lld",(long long)best));
+  results.push_back("");
+  delete p;
+
+  //
+  // Memory
+  //
+  struct rusage usage;
+  memset(&usage,0,sizeof(usage));
+  getrusage(RUSAGE_SELF,&usage);
+  printf("  %24s: %10ld kB\n","peak RSS",usage.ru_maxrss);
+  results.push_back("[Memory]");
+  results.push_back(QString::asprintf("PeakRssKbytes=%ld",usage.ru_maxrss));
+
+  if(!d_results.isEmpty()) {
+    WriteResults(d_results,results);
+  }
+}
+
+
+qint64 MainObject::GenerateConfig(const QString &dirpath) const
+{
+  qint64 ret=0;
+
+  for(int i=0;i<d_files;i++) {
+    QByteArray data;
+    for(int j=i;j<d_sections;j+=d_files) {
+      data+=("["+SectionName(j)+"]\n").toUtf8();
+      if(d_section_ids) {
+	data+=QString::asprintf("Id=%d\n",j).toUtf8();
+      }
+      for(int k=0;k<d_tags;k++) {
+	for(int l=0;l<d_repeats;l++) {
+	  switch(k%4) {
+	  case 0:
+	    data+=QString::asprintf("Tag%d=Value %d of section %d\n",k,l,j).
+	      toUtf8();
+	    break;
+
+	  case 1:
+	    data+=QString::asprintf("Tag%d=%d\n",k,j*d_tags+l).toUtf8();
+	    break;
+
+	  case 2:
+	    data+=QString::asprintf("Tag%d=%d.%d\n",k,j,l).toUtf8();
+	    break;
+
+	  case 3:
+	    data+=QString::asprintf("Tag%d=%s\n",k,((j+l)%2)?"Yes":"No").
+	      toUtf8();
+	    break;
+	  }
+	}
+      }
+      data+="\n";
+    }
+    QFile file(dirpath+QString::asprintf("/bench_%04d.conf",i));
+    if((!file.open(QIODevice::WriteOnly))||
+       (file.write(data)!=data.size())) {
+      fprintf(stderr,"bench_profile: unable to write \"%s\"\n",
+	      file.fileName().toUtf8().constData());
+      exit(1);
+    }
+    ret+=data.size();
+  }
+
+  return ret;
+}
+
+
+//
+// With section IDs, sections share a handful of names and are told apart
+// by their IDs, as they are in a typical extended configuration.
+//
+QString MainObject::SectionName(int n) const
+{
+  if(d_section_ids) {
+    return QString::asprintf("Section%d",n%BENCH_PROFILE_SECTION_NAMES);
+  }
+  return QString::asprintf("Section%d",n);
+}
+
+
+void MainObject::WriteResults(const QString &filename,
+			      const QStringList &results) const
+{
+  QByteArray data=(results.join("\n")+"\n").toUtf8();
+
+  if(filename=="-") {
+    fwrite(data.constData(),1,data.size(),stdout);
+    return;
+  }
+  QFile file(filename);
+  if((!file.open(QIODevice::WriteOnly|QIODevice::Truncate))||
+     (file.write(data)!=data.size())) {
+    fprintf(stderr,"bench_profile: unable to write \"%s\"\n",
+	    filename.toUtf8().constData());
+    exit(1);
+  }
+}
+
+
+qint64 MainObject::Percentile(const QVector<qint64> &sorted,
+			      int permille) const
+{
+  if(sorted.size()==0) {
+    return 0;
+  }
+  return sorted.at(qMin(sorted.size()-1,
+			(int)((qint64)sorted.size()*permille/1000)));
+}
+
+
+QByteArray MainObject::GenerateData(int size) const
+{
+  QByteArray ret;
+  int section=0;
+
+  ret.reserve(size+1024);
+  while(ret.size()<size) {
+    ret+=QString::asprintf("[Section%d]\n",section%64).toUtf8();
+    ret+="; Generated by bench_profile\n";
+    for(int i=0;i<16;i++) {
+      ret+=QString::asprintf("Tag%d=Value number %d of section %d\n",
+			     i,i,section).toUtf8();
+    }
+    ret+="\n";
+    section++;
+  }
+
+  return ret;
+}
+
+
+double MainObject::Rate(qint64 bytes,qint64 nsecs) const
+{
+  if(nsecs<=0) {
+    return 0.0;
+  }
+  return ((double)bytes/1048576.0)/((double)nsecs/1000000000.0);
+}
+
+
+int main(int argc,char *argv[])
+{
+  QCoreApplication a(argc,argv);
+
+  new MainObject();
+  return a.exec();
+}
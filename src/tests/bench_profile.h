@@ -0,0 +1,86 @@
+// bench_profile.h
+//
+// Benchmarks for the Profile configurator class.
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#ifndef BENCH_PROFILE_H
+#define BENCH_PROFILE_H
+
+#include <QByteArray>
+#include <QHostAddress>
+#include <QList>
+#include <QObject>
+#include <QStringList>
+#include <QTime>
+#include <QVector>
+
+#define BENCH_PROFILE_USAGE \
+  "--test=scanner|binding|memory|profile [--size=<mbytes>] [--passes=<n>]\n"\
+  "  [--sections=<n>] [--tags=<n>] [--repeats=<n>] [--files=<n>]\n"\
+  "  [--section-ids] [--lookups=<n>] [--results=<file>|-]\n\n"
+#define BENCH_PROFILE_BINDING_READS 100000
+#define BENCH_PROFILE_DEFAULT_SECTIONS 1000
+#define BENCH_PROFILE_DEFAULT_TAGS 16
+#define BENCH_PROFILE_DEFAULT_LOOKUPS 100000
+#define BENCH_PROFILE_SECTION_NAMES 16
+
+struct BenchSettings
+{
+  QString hostname;
+  int port;
+  QHostAddress address;
+  bool enabled;
+  QTime start_time;
+  QString card;
+  int rate;
+  double gain;
+  int mask;
+  QList<int> channels;
+};
+
+class MainObject : public QObject
+{
+  Q_OBJECT
+ public:
+  MainObject();
+
+ private:
+  void RunScannerBenchmark(int passes);
+  void RunBindingBenchmark(int passes);
+  void RunMemoryBenchmark();
+  void MeasureMemory(const QString &label,const QByteArray &data) const;
+  qint64 HeapBytes() const;
+  void RunProfileBenchmark(int passes);
+  qint64 GenerateConfig(const QString &dirpath) const;
+  QString SectionName(int n) const;
+  void WriteResults(const QString &filename,const QStringList &results) const;
+  qint64 Percentile(const QVector<qint64> &sorted,int permille) const;
+  QByteArray GenerateData(int size) const;
+  double Rate(qint64 bytes,qint64 nsecs) const;
+  QByteArray d_data;
+  int d_sections;
+  int d_tags;
+  int d_repeats;
+  int d_files;
+  int d_lookups;
+  bool d_section_ids;
+  QString d_results;
+};
+
+
+#endif  // BENCH_PROFILE_H
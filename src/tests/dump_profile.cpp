@@ -20,15 +20,14 @@
 
 #include <stdio.h>
 #include <stdlib.h>
-#include <unistd.h>
 
 #include <QCoreApplication>
 #include <QFileInfo>
-#include <QProcess>
 #include <QStringList>
 
 #include <cmdswitch.h>
 #include <profile.h>
+#include <profilediff.h>
 
 #include "dump_profile.h"
 
@@ -39,10 +38,17 @@ MainObject::MainObject()
   QStringList err_msgs;
   QStringList paths;
   bool use_section_ids=false;
+  bool stats=false;
   QString compare_to;
+  QString build_compiled;
+  QString verify_compiled;
   
   CmdSwitch *cmd=new CmdSwitch("dump_profile",VERSION,DUMP_PROFILE_USAGE);
   for(int i=0;i<cmd->keys();i++) {
+    if(cmd->key(i)=="--build-compiled") {
+      build_compiled=cmd->value(i).trimmed();
+      cmd->setProcessed(i,true);
+    }
     if(cmd->key(i)=="--compare-to") {
       compare_to=cmd->value(i).trimmed();
       cmd->setProcessed(i,true);
@@ -51,10 +57,18 @@ MainObject::MainObject()
       paths.push_back(cmd->value(i).trimmed());
       cmd->setProcessed(i,true);
     }
+    if(cmd->key(i)=="--stats") {
+      stats=true;
+      cmd->setProcessed(i,true);
+    }
     if(cmd->key(i)=="--use-section-ids") {
       use_section_ids=true;
       cmd->setProcessed(i,true);
     }
+    if(cmd->key(i)=="--verify-compiled") {
+      verify_compiled=cmd->value(i).trimmed();
+      cmd->setProcessed(i,true);
+    }
     if(!cmd->processed(i)) {
       fprintf(stderr,"dump_profile: unrecognized option \"%s\"\n",
 	      cmd->key(i).toUtf8().constData());
@@ -63,6 +77,7 @@ MainObject::MainObject()
   }
 
   Profile *p=new Profile(use_section_ids);
+  p->setStatsEnabled(stats);
   for(int i=0;i<paths.size();i++) {
     if(p->load(paths.at(i),&err_msgs)<0) {
       fprintf(stderr,"[%d]: %s",i,err_msgs.at(i).toUtf8().constData());
@@ -74,52 +89,68 @@ MainObject::MainObject()
       }
     }
   }
+  if(stats) {
+    fprintf(stderr,"%s",p->stats().dump().toUtf8().constData());
+  }
 
-  if(compare_to.isEmpty()) {
+  if(!build_compiled.isEmpty()) {
     //
-    // Print the dump
+    // Write a compiled snapshot
     //
-    printf("%s",p->dump().toUtf8().constData());
+    if(!p->saveCompiled(build_compiled,&err_msg)) {
+      fprintf(stderr,"dump_profile: failed to write \"%s\" [%s]\n",
+	      build_compiled.toUtf8().constData(),
+	      err_msg.toUtf8().constData());
+      exit(1);
+    }
+    exit(0);
   }
-  else {
+
+  if(!verify_compiled.isEmpty()) {
     //
-    // Diff the dump against an exemplar
+    // Check a compiled snapshot against its sources
     //
-    FILE *f=fopen("OUTPUT","w");
-    if(f==NULL) {
-      fprintf(stderr,
-	      "dump_profile: failed to create temp file \"OUTPUT\" [%s]\n",
-	      strerror(errno));
+    Profile *c=new Profile(use_section_ids);
+    if(!c->loadCompiled(verify_compiled,&err_msg)) {
+      fprintf(stderr,"dump_profile: \"%s\" is not valid [%s]\n",
+	      verify_compiled.toUtf8().constData(),
+	      err_msg.toUtf8().constData());
       exit(1);
     }
-    fprintf(f,"%s",p->dump().toUtf8().constData());
-    fclose(f);
-
-    QStringList args;
-    args.push_back("-u");
-    args.push_back(compare_to);
-    args.push_back("OUTPUT");
-    QProcess *proc=new QProcess(this);
-    proc->start("diff",args);
-    proc->waitForFinished();
-    if(proc->exitStatus()!=QProcess::NormalExit) {
-      fprintf(stderr,"dump_profile: diff process crashed\n");
+    if((paths.size()>0)&&(c->dump()!=p->dump())) {
+      fprintf(stderr,"dump_profile: \"%s\" does not match its sources\n",
+	      verify_compiled.toUtf8().constData());
       exit(1);
     }
-    if(proc->exitCode()>=2) {
-      fprintf(stderr,"dump_profile: diff returned error [%s]\n",
-	      proc->readAllStandardError().constData());
+    printf("%s: OK\n",verify_compiled.toUtf8().constData());
+    exit(0);
+  }
+
+  if(compare_to.isEmpty()) {
+    //
+    // Print the dump
+    //
+    p->dump(stdout);
+  }
+  else {
+    //
+    // Diff the dump against an exemplar
+    //
+    Profile *e=new Profile(use_section_ids);
+    if(!e->loadFile(compare_to,&err_msg)) {
+      fprintf(stderr,"dump_profile: failed to load \"%s\" [%s]\n",
+	      compare_to.toUtf8().constData(),err_msg.toUtf8().constData());
       exit(1);
     }
-    if(proc->exitCode()!=0) {
+    ProfileDiff *diff=new ProfileDiff(e,p);
+    if(!diff->isEmpty()) {
       printf("**** DIFF BEGINS ****\n");
-    }
-    printf("%s",proc->readAllStandardOutput().constData());
-    if(proc->exitCode()!=0) {
+      printf("%s",diff->unified(compare_to+" (dump)",paths.join(",")).
+	     toUtf8().constData());
       printf("**** DIFF ENDS ****\n");
     }
-    delete proc;
-    unlink("OUTPUT");
+    delete diff;
+    delete e;
   }
 
   exit(0);
@@ -23,7 +23,7 @@
 
 #include <QObject>
 
-#define DUMP_PROFILE_USAGE "--compare-to=<exemplar> --use-section-ids --path=<glob-path> [...]\n\n"
+#define DUMP_PROFILE_USAGE "--compare-to=<exemplar> --use-section-ids --stats --build-compiled=<file> --verify-compiled=<file> --path=<glob-path> [...]\n\n--compare-to=<exemplar>\n     Load <exemplar> as a profile and print a unified diff between its\n     dump and the dump of the loaded profile. The comparison is of\n     contents only: comments, ordering and formatting in <exemplar> are\n     ignored, and hunk line numbers refer to the dump of <exemplar>,\n     not to the file itself.\n\n--stats\n     Collect statistics while loading, and print them to standard error\n     once every --path has been loaded.\n\n--build-compiled=<file>\n     Write the loaded profile to <file> as a compiled snapshot, then exit\n     without printing the dump.\n\n--verify-compiled=<file>\n     Load the compiled snapshot in <file> and check that it is valid.\n     If any --path is given, also check that the snapshot's contents\n     match those of the loaded profile. Prints \"<file>: OK\" and exits\n     zero on success.\n\n"
 
 class MainObject : public QObject
 {
@@ -21,9 +21,26 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include <algorithm>
+#include <utility>
+
+#include <QBuffer>
 #include <QCoreApplication>
 #include <QDir>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFileInfo>
 #include <QProcess>
+#include <QTemporaryDir>
+#include <QTemporaryFile>
+#include <QThread>
+#include <QTimer>
+
+#include <profilebinding.h>
+#include <profilediff.h>
+#include <profileloader.h>
+#include <profilewatcher.h>
+#include <sharedprofile.h>
 
 #include "run_tests.h"
 #include "test_methods.h"
@@ -63,6 +80,13 @@ MainObject::MainObject()
     exit(1);
   }
   RunLegacyTests(p,&total_pass,&total_fail);
+  Profile::Key key("Tests","StringValue");
+  bool key_ok=p->stringValue(key)=="Now is the time";
+  p->clear();
+  key_ok=key_ok&&(p->valueCount(key)==0);
+  p->loadFile("../../fixtures/legacy.conf");
+  key_ok=key_ok&&(p->stringValue(key)=="Now is the time");
+  PrintSingleResult("Key Revalidation",key_ok,&total_pass,&total_fail);
   delete p;
   printf("\n");
 
@@ -77,6 +101,18 @@ MainObject::MainObject()
   delete p;
   printf("\n");
 
+  printf("**** Extended Format (Lazy) ****\n");
+  p=new Profile(true);
+  p->setLazyLoad(true);
+  if(!p->loadFile("../../fixtures/extended.conf",&err_msg)) {
+    fprintf(stderr,"run_tests: failed to open test data [%s]\n",
+	    err_msg.toUtf8().constData());
+    exit(1);
+  }
+  RunExtendedTests(p,&total_pass,&total_fail);
+  delete p;
+  printf("\n");
+
   printf("**** Extended Multipart Format ****\n");
   p=new Profile();
   num=p->load("../../fixtures*/extended_part*.conf",&err_msgs);
@@ -99,12 +135,156 @@ MainObject::MainObject()
 
   RunLegacyTests(p,&total_pass,&total_fail);
   printf("\n");
+  QString serial_dump=p->dump();
+  delete p;
+
+  printf("**** Extended Multipart Format (Concurrent) ****\n");
+  QStringList serial_msgs;
+  p=new Profile();
+  p->load("../../fixtures/extended_part*.conf",&serial_msgs);
+  delete p;
+  err_msgs.clear();
+  p=new Profile();
+  p->setConcurrentLoad(true);
+  num=p->load("../../fixtures/extended_part*.conf",&err_msgs);
+  PrintTitle("Directory Load Concurrent Test");
+  PrintResultState(num==4,&total_pass,&total_fail);
+  PrintSingleResult("Concurrent Message Order",err_msgs==serial_msgs,
+		    &total_pass,&total_fail);
+  PrintSingleResult("Concurrent Dump",p->dump()==serial_dump,
+		    &total_pass,&total_fail);
+
+  RunLegacyTests(p,&total_pass,&total_fail);
+  printf("\n");
+  delete p;
+
+  printf("**** Extended Multipart Format (Lazy) ****\n");
+  err_msgs.clear();
+  p=new Profile();
+  p->setLazyLoad(true);
+  num=p->load("../../fixtures/extended_part*.conf",&err_msgs);
+  PrintTitle("Directory Load Lazy Test");
+  PrintResultState(num==4,&total_pass,&total_fail);
+  PrintSingleResult("Lazy Message Order",err_msgs==serial_msgs,
+		    &total_pass,&total_fail);
+
+  RunLegacyTests(p,&total_pass,&total_fail);
+  PrintSingleResult("Lazy Dump",p->dump()==serial_dump,
+		    &total_pass,&total_fail);
+
+  //
+  // Values added to a section before and after a lazy load must keep
+  // their order
+  //
+  QStringList before;
+  before.push_back("[Tests]");
+  before.push_back("IntegerValue=1");
+  QStringList after;
+  after.push_back("[Tests]");
+  after.push_back("IntegerValue=2");
+  Profile *eager=new Profile();
+  eager->addSource(before);
+  eager->loadFile("../../fixtures/legacy.conf");
+  eager->addSource(after);
+  p->clear();
+  p->addSource(before);
+  p->loadFile("../../fixtures/legacy.conf");
+  p->addSource(after);
+  PrintSingleResult("Lazy Mixed Source Order",
+		    (p->intValues("Tests","IntegerValue")==
+		     eager->intValues("Tests","IntegerValue"))&&
+		    (p->dump()==eager->dump()),&total_pass,&total_fail);
+  delete eager;
+
+  //
+  // Copies materialize independently of the original
+  //
+  Profile *lazy_src=new Profile();
+  lazy_src->setLazyLoad(true);
+  lazy_src->load("../../fixtures/extended_part*.conf",NULL);
+  Profile lazy_copy(*lazy_src);
+  Profile lazy_assigned;
+  lazy_assigned=*lazy_src;
+  PrintSingleResult("Lazy Copy",(lazy_copy.dump()==serial_dump)&&
+		    (lazy_src->dump()==serial_dump)&&
+		    (lazy_assigned.dump()==serial_dump),
+		    &total_pass,&total_fail);
+  delete lazy_src;
+
+  //
+  // A file replaced by renaming another over it is still read from the
+  // original
+  //
+  QTemporaryDir lazy_dir;
+  QString lazy_filename=lazy_dir.path()+"/lazy.conf";
+  WriteFile(lazy_filename,"[Tests]\nValue=1\n[Other]\nValue=2\n");
+  p->clear();
+  p->loadFile(lazy_filename);
+  WriteFile(lazy_dir.path()+"/lazy.new","[Tests]\nValue=3\n");
+  rename((lazy_dir.path()+"/lazy.new").toUtf8().constData(),
+	 lazy_filename.toUtf8().constData());
+  PrintSingleResult("Lazy Replaced Source",
+		    (p->intValue("Tests","Value",-1)==1)&&
+		    (p->intValue("Other","Value",-1)==2)&&
+		    p->lazyLoadErrors().isEmpty(),&total_pass,&total_fail);
+
+  //
+  // A file rewritten in place before its sections are read is read again
+  // as it is now, and the change reported
+  //
+  p->clear();
+  p->loadFile(lazy_filename);
+  WriteFile(lazy_filename,"[Tests]\nValue=4\n");
+  PrintSingleResult("Lazy Rewritten Source",
+		    (p->intValue("Tests","Value",-1)==4)&&
+		    (p->lazyLoadErrors().size()==1),&total_pass,&total_fail);
+  printf("\n");
   delete p;
 
+  printf("**** In-Memory Load Tests ****\n");
+  RunMemoryLoadTests(&total_pass,&total_fail);
+  printf("\n");
+
   printf("**** Profile Dump Tests ****\n");
   RunDumpTests(&total_pass,&total_fail);
   printf("\n");
 
+  printf("**** Large File Tests ****\n");
+  RunLargeFileTests(&total_pass,&total_fail);
+  printf("\n");
+
+  printf("**** Asynchronous Load Tests ****\n");
+  RunAsyncLoadTests(&total_pass,&total_fail);
+  printf("\n");
+
+  printf("**** Load Scaling Tests ****\n");
+  RunScalingTests(&total_pass,&total_fail);
+  printf("\n");
+
+  printf("**** Compiled Profile Tests ****\n");
+  RunCompiledTests(&total_pass,&total_fail);
+  printf("\n");
+
+  printf("**** Profile Statistics Tests ****\n");
+  RunStatsTests(&total_pass,&total_fail);
+  printf("\n");
+
+  printf("**** Shared File Cache Tests ****\n");
+  RunFileCacheTests(&total_pass,&total_fail);
+  printf("\n");
+
+  printf("**** Layered Profile Tests ****\n");
+  RunLayerTests(&total_pass,&total_fail);
+  printf("\n");
+
+  printf("**** Profile Watcher Tests ****\n");
+  RunWatcherTests(&total_pass,&total_fail);
+  printf("\n");
+
+  printf("**** Shared Profile Tests ****\n");
+  RunSharedProfileTests(&total_pass,&total_fail);
+  printf("\n");
+
   printf("**** Sendmail Interface ****\n");
   RunSendmailTests(&total_pass,&total_fail);
   printf("\n");
@@ -142,6 +322,14 @@ bool MainObject::RunLegacyTests(Profile *p,int *pass_ctr,int *fail_ctr) const
   strings.push_back("of their country!");
   result_ok=(p->stringValues("Tests","StringValue")==strings);
   PrintSingleResult("String Multi-Value",result_ok,&pass,&fail);
+  result_ok=(p->stringValuesRef("Tests","StringValue")==strings)&&
+    p->stringValuesRef("Tests","StringMissing").isEmpty();
+  PrintSingleResult("String Reference",result_ok,&pass,&fail);
+  result_ok=(p->valueCount("Tests","StringValue")==4)&&
+    (p->valueAt("Tests","StringValue",1)==QString("for all good men"))&&
+    p->valueAt("Tests","StringValue",4).isNull()&&
+    (p->valueCount("Tests","StringMissing")==0);
+  PrintSingleResult("String Indexed Value",result_ok,&pass,&fail);
   
   result_ok=p->intValue("Tests","IntegerValue",4321,&ok)==1234;
   PrintDualResult("Integer Found",result_ok,ok==true,&pass,&fail);
@@ -154,6 +342,24 @@ bool MainObject::RunLegacyTests(Profile *p,int *pass_ctr,int *fail_ctr) const
   ints.push_back(4567);
   result_ok=(p->intValues("Tests","IntegerValue")==ints);
   PrintSingleResult("Integer Multi-Value",result_ok,&pass,&fail);
+  result_ok=(p->intValues("Tests","IntegerValue")==ints)&&
+    (p->intValue("Tests","IntegerValue",4321)==1234);
+  PrintSingleResult("Integer Repeat Read",result_ok,&pass,&fail);
+  Profile::Key int_key("Tests","IntegerValue");
+  result_ok=(p->intValue(int_key,4321,&ok)==1234)&&
+    (p->intValues(int_key)==ints);
+  PrintDualResult("Integer Key",result_ok,ok==true,&pass,&fail);
+  int int_buf[8];
+  QList<int> errors;
+  result_ok=(p->readIntValues("Tests","IntegerValue",int_buf,8,&errors)==4)&&
+    errors.isEmpty();
+  for(int i=0;i<ints.size();i++) {
+    result_ok=result_ok&&(int_buf[i]==ints.at(i));
+  }
+  result_ok=result_ok&&
+    (p->readIntValues("Tests","IntegerValue",int_buf,2)==2)&&
+    (p->readIntValues("Tests","IntegerMissing",int_buf,8)==0);
+  PrintSingleResult("Integer Bulk Read",result_ok,&pass,&fail);
   
   result_ok=p->hexValue("Tests","HexValue",4321,&ok)==1234;
   PrintDualResult("Hex Found",result_ok,ok==true,&pass,&fail);
@@ -161,6 +367,12 @@ bool MainObject::RunLegacyTests(Profile *p,int *pass_ctr,int *fail_ctr) const
   PrintDualResult("Hex Missing",result_ok,ok==false,&pass,&fail);
   result_ok=(p->hexValues("Tests","HexValue")==ints);
   PrintSingleResult("Hex Multi-Value",result_ok,&pass,&fail);
+  result_ok=(p->readHexValues("Tests","HexValue",int_buf,8,&errors)==4)&&
+    errors.isEmpty();
+  for(int i=0;i<ints.size();i++) {
+    result_ok=result_ok&&(int_buf[i]==ints.at(i));
+  }
+  PrintSingleResult("Hex Bulk Read",result_ok,&pass,&fail);
 
   result_ok=p->doubleValue("Tests","DoubleValue",2.71,&ok)==3.1415928;
   PrintDualResult("Double Found",result_ok,ok==true,&pass,&fail);
@@ -173,6 +385,56 @@ bool MainObject::RunLegacyTests(Profile *p,int *pass_ctr,int *fail_ctr) const
   doubles.push_back(12.5663712);
   result_ok=(p->doubleValues("Tests","DoubleValue")==doubles);
   PrintSingleResult("Double Multi-Value",result_ok,&pass,&fail);
+  double double_buf[8];
+  Profile::Key double_key("Tests","DoubleValue");
+  result_ok=
+    (p->readDoubleValues(double_key,double_buf,8,&errors)==4)&&
+    errors.isEmpty();
+  for(int i=0;i<doubles.size();i++) {
+    result_ok=result_ok&&(double_buf[i]==doubles.at(i));
+  }
+  PrintSingleResult("Double Bulk Read",result_ok,&pass,&fail);
+
+  Profile *bad=new Profile();
+  bad->addSource(QStringList()<<"[Tests]"<<"Value=12"<<"Value=1x"<<
+		 "Value= -7 "<<"Value=99999999999"<<"Value="<<"Value=2.5e3");
+  result_ok=(bad->readIntValues("Tests","Value",int_buf,8,&errors)==6)&&
+    (errors==(QList<int>()<<1<<3<<4<<5))&&(int_buf[0]==12)&&
+    (int_buf[1]==0)&&(int_buf[2]==-7);
+  errors.clear();
+  result_ok=result_ok&&
+    (bad->readDoubleValues("Tests","Value",double_buf,8,&errors)==6)&&
+    (errors==(QList<int>()<<1<<4))&&(double_buf[3]==99999999999.0)&&
+    (double_buf[5]==2500.0);
+  PrintSingleResult("Bulk Read Malformed Values",result_ok,&pass,&fail);
+  delete bad;
+
+  QStringList sized_values;
+  sized_values.push_back("");
+  sized_values.push_back("fifteen bytes!!");
+  sized_values.push_back("sixteen bytes!!!");
+  sized_values.push_back(
+	     QString::fromUtf8("Gr\xc3\xbc\xc3\x9f""e \xe2\x82\xac")+
+	     QString(200,'x'));
+  QStringList sized_lines;
+  sized_lines.push_back("[Tests]");
+  for(int i=0;i<sized_values.size();i++) {
+    sized_lines.push_back("Value="+sized_values.at(i));
+  }
+  sized_lines.push_back("Number=0000000000000000000000042");
+  Profile *sized=new Profile();
+  sized->addSource(sized_lines);
+  result_ok=(sized->stringValues("Tests","Value")==sized_values)&&
+    (sized->valueAt("Tests","Value",3)==sized_values.at(3))&&
+    (sized->intValue("Tests","Number")==42);
+  PrintSingleResult("Inline and Out-of-Line Values",result_ok,&pass,&fail);
+  const QStringList &sized_ref=sized->stringValuesRef("Tests","Value");
+  QStringView sized_view=sized->valueAt("Tests","Value",3);
+  sized->addSource(QStringList()<<"[Tests]"<<"Value=appended");
+  result_ok=(sized_ref==sized_values)&&(sized_view==sized_values.at(3))&&
+    (sized->valueCount("Tests","Value")==(sized_values.size()+1));
+  PrintSingleResult("Value References Across Loads",result_ok,&pass,&fail);
+  delete sized;
   
   result_ok=p->boolValue("Tests","BoolYesValue",false,&ok)==true;
   PrintDualResult("BoolYes Found",result_ok,ok==true,&pass,&fail);
@@ -320,6 +582,29 @@ bool MainObject::RunLegacyTests(Profile *p,int *pass_ctr,int *fail_ctr) const
   result_ok=(p->addressValues("Tests","IpAddressValidValue")==addrs);
   PrintSingleResult("IpAddress Multi-Value",result_ok,&pass,&fail);
 
+  static const ProfileBinding<BindingTest> binding=
+    ProfileBinding<BindingTest>().
+    bind("Tests","StringValue",&BindingTest::string_value).
+    bind("Tests","IntegerValue",&BindingTest::int_value).
+    bind("Tests","IntegerValue",&BindingTest::int_values).
+    bindHex("Tests","HexValue",&BindingTest::hex_value).
+    bind("Tests","DoubleValue",&BindingTest::double_value).
+    bind("Tests","BoolYesValue",&BindingTest::bool_value).
+    bind("Tests","TimeHHMMSSMorningValue",&BindingTest::time_value).
+    bind("Tests","IpAddressValidValue",&BindingTest::address_value).
+    bind("Tests","IntegerMissing",&BindingTest::missing_value,4321);
+  BindingTest bound;
+  QStringList missing;
+  result_ok=(!binding.read(p,&bound,&missing))&&
+    (missing==(QStringList()<<"Tests/IntegerMissing"))&&
+    (bound.string_value=="Now is the time")&&(bound.int_value==1234)&&
+    (bound.int_values==ints)&&(bound.hex_value==1234)&&
+    (bound.double_value==3.1415928)&&bound.bool_value&&
+    (bound.time_value==QTime(9,30,45))&&
+    (bound.address_value==QHostAddress("1.2.3.4"))&&
+    (bound.missing_value==4321);
+  PrintSingleResult("Struct Binding",result_ok,&pass,&fail);
+
   *pass_ctr+=pass;
   *fail_ctr+=fail;
 
@@ -354,6 +639,17 @@ bool MainObject::RunExtendedTests(Profile *p,int *pass_ctr,int *fail_ctr) const
   result_ok=(p->stringValues("Tests","Second","StringValue")==strings);
   PrintSingleResult("String Multi-Value [Id=Second]",result_ok,&pass,&fail);
 
+  static const ProfileBinding<BindingTest> binding=
+    ProfileBinding<BindingTest>().
+    bind("Tests","Second","StringValue",&BindingTest::string_value).
+    bind("Tests","Second","IntegerMissing",&BindingTest::missing_value,4321);
+  BindingTest bound;
+  QStringList missing;
+  result_ok=(!binding.read(p,&bound,&missing))&&
+    (missing==(QStringList()<<"Tests|Second/IntegerMissing"))&&
+    (bound.string_value=="to come to the aid")&&(bound.missing_value==4321);
+  PrintSingleResult("Struct Binding [Id=Second]",result_ok,&pass,&fail);
+
   QList<int> ints;
   ints.push_back(1234);
   ints.push_back(2345);
@@ -605,6 +901,108 @@ bool MainObject::RunSendmailTests(int *pass_ctr,int *fail_ctr) const
 }
 
 
+bool MainObject::RunMemoryLoadTests(int *pass_ctr,int *fail_ctr)
+{
+  int pass=0;
+  int fail=0;
+  bool result_ok=false;
+  Profile *p=NULL;
+
+  Profile *ref=new Profile();
+  ref->loadFile("../../fixtures/legacy.conf");
+  QString expected=ref->dump();
+  delete ref;
+
+  QFile file("../../fixtures/legacy.conf");
+  if(!file.open(QIODevice::ReadOnly)) {
+    fprintf(stderr,"run_tests: failed to open test data\n");
+    exit(1);
+  }
+  QByteArray bytes=file.readAll();
+
+  p=new Profile();
+  result_ok=p->loadData(bytes.constData(),bytes.size())&&
+    (p->dump()==expected);
+  PrintSingleResult("Load From Pointer",result_ok,&pass,&fail);
+  delete p;
+
+  p=new Profile();
+  result_ok=p->loadData(bytes)&&(p->dump()==expected);
+  PrintSingleResult("Load From QByteArray",result_ok,&pass,&fail);
+  delete p;
+
+  QBuffer buffer(&bytes);
+  buffer.open(QIODevice::ReadOnly);
+  QString err_msg;
+  p=new Profile();
+  result_ok=p->loadDevice(&buffer,&err_msg)&&(p->dump()==expected)&&
+    buffer.atEnd()&&
+    (err_msg==QString::asprintf("loaded %d bytes from buffer",bytes.size()));
+  PrintSingleResult("Load From QBuffer",result_ok,&pass,&fail);
+  delete p;
+
+  file.seek(0);
+  p=new Profile();
+  result_ok=p->loadDevice(&file,&err_msg)&&(p->dump()==expected)&&
+    file.atEnd()&&
+    (err_msg==QString::asprintf("loaded %d bytes from file \"%s\"",
+				bytes.size(),
+				file.fileName().toUtf8().constData()));
+  PrintSingleResult("Load From QFile",result_ok,&pass,&fail);
+  delete p;
+
+  QProcess *proc=new QProcess(this);
+  proc->start("cat",QStringList()<<"../../fixtures/legacy.conf");
+  proc->waitForFinished();
+  p=new Profile();
+  result_ok=p->loadDevice(proc)&&(p->dump()==expected);
+  PrintSingleResult("Load From Sequential Device",result_ok,&pass,&fail);
+  delete p;
+  delete proc;
+
+  p=new Profile();
+  result_ok=!p->loadDevice(NULL);
+  PrintSingleResult("Load From Null Device",result_ok,&pass,&fail);
+  delete p;
+
+  p=new Profile();
+  result_ok=p->loadData(QByteArray("\xEF\xBB\xBF[Tests]\nValue=1\n"))&&
+    (p->intValue("Tests","Value")==1);
+  PrintSingleResult("Load UTF-8 With Byte Order Mark",result_ok,&pass,&fail);
+  delete p;
+
+  QString text=QString::fromUtf8(" [Tests]\nValue=2\xC2\xA0\n");
+  QByteArray utf16("\xFF\xFE",2);
+  for(int i=0;i<text.size();i++) {
+    utf16.append((char)(text.at(i).unicode()&0xFF));
+    utf16.append((char)(text.at(i).unicode()>>8));
+  }
+  p=new Profile();
+  result_ok=p->loadData(utf16)&&(p->intValue("Tests","Value")==2)&&
+    (p->stringValue("Tests","Value")=="2");
+  PrintSingleResult("Load UTF-16",result_ok,&pass,&fail);
+  delete p;
+
+  QStringList lines=QString::fromUtf8(bytes).split("\n");
+  for(int i=0;i<lines.size();i++) {
+    lines[i]=lines.at(i).trimmed();
+  }
+  ref=new Profile();
+  ref->addSource(lines);
+  p=new Profile();
+  result_ok=p->addSource(std::move(lines))&&lines.isEmpty()&&
+    (p->dump()==ref->dump());
+  PrintSingleResult("Consuming addSource()",result_ok,&pass,&fail);
+  delete p;
+  delete ref;
+
+  *pass_ctr+=pass;
+  *fail_ctr+=fail;
+
+  return fail==0;
+}
+
+
 bool MainObject::RunDumpTests(int *pass_ctr,int *fail_ctr)
 {
   int pass=0;
@@ -616,6 +1014,79 @@ bool MainObject::RunDumpTests(int *pass_ctr,int *fail_ctr)
 	   &pass,&fail);
   DumpTest("extended_part*","extended_all.conf",true,"Multi-File Mode Dump Test",
 	   &pass,&fail); 
+
+  //
+  // Changed values and whole sections, in unified format
+  //
+  Profile *from=new Profile(true);
+  from->loadData(QByteArray("[Alpha]\nId=1\nA=1\nB=1\nB=2\nB=3\n"
+			    "[Beta]\nId=1\nC=1\n"));
+  Profile *to=new Profile(true);
+  to->loadData(QByteArray("[Alpha]\nId=1\nA=1\nB=1\nB=5\nB=3\n"
+			  "[Gamma]\nId=1\nD=1\n"));
+  ProfileDiff *diff=new ProfileDiff(from,to);
+  QString expected_diff=
+    "--- from\n"
+    "+++ to\n"
+    "@@ -2,8 +2,8 @@\n"
+    " Id=1\n"
+    " A=1\n"
+    " B=1\n"
+    "-B=2\n"
+    "+B=5\n"
+    " B=3\n"
+    "-[Beta]\n"
+    "-Id=1\n"
+    "-C=1\n"
+    "+[Gamma]\n"
+    "+Id=1\n"
+    "+D=1\n";
+  PrintSingleResult("Structural Diff Test",
+		    (diff->unified("from","to")==expected_diff)&&
+		    (diff->removedLines()==4)&&(diff->addedLines()==4),
+		    &pass,&fail);
+  delete diff;
+  diff=new ProfileDiff(from,from);
+  PrintSingleResult("Structural Diff Identity Test",
+		    diff->isEmpty()&&diff->unified("from","to").isEmpty(),
+		    &pass,&fail);
+  delete diff;
+  delete to;
+  delete from;
+
+  //
+  // Streamed output must match dump(), including multi-byte UTF-8
+  //
+  Profile *p=new Profile(true);
+  p->load("../../fixtures/extended_part*.conf",NULL);
+  p->addSource(QStringList()<<"[Unicode]"<<
+	       QString::fromUtf8("Value=caf\xc3\xa9 \xe2\x82\xac "
+				 "\xf0\x9d\x84\x9e"));
+  QByteArray expected=p->dump().toUtf8();
+  QByteArray streamed;
+  QBuffer buffer(&streamed);
+  buffer.open(QIODevice::WriteOnly);
+  bool ok=p->dump(&buffer);
+  buffer.close();
+  PrintSingleResult("Streamed QIODevice Dump Test",ok&&(streamed==expected),
+		    &pass,&fail);
+  streamed.clear();
+  FILE *f=tmpfile();
+  ok=(f!=NULL)&&p->dump(f)&&(fflush(f)==0);
+  if(ok) {
+    char data[4096];
+    size_t n;
+    rewind(f);
+    while((n=fread(data,1,sizeof(data),f))>0) {
+      streamed.append(data,n);
+    }
+  }
+  if(f!=NULL) {
+    fclose(f);
+  }
+  PrintSingleResult("Streamed FILE Dump Test",ok&&(streamed==expected),
+		    &pass,&fail);
+  delete p;
   
   *pass_ctr+=pass;
   *fail_ctr+=fail;
@@ -624,33 +1095,858 @@ bool MainObject::RunDumpTests(int *pass_ctr,int *fail_ctr)
 }
 
 
+bool MainObject::RunLargeFileTests(int *pass_ctr,int *fail_ctr)
+{
+  int pass=0;
+  int fail=0;
+
+  //
+  // Big enough to be split into chunks and parsed in parallel
+  //
+  QByteArray data;
+  for(int i=0;data.size()<(10*1048576);i++) {
+    data+=QString::asprintf("[Section%d]\n",i%7).toUtf8();
+    data+=QString::asprintf("Id=Id%d\n",i%5).toUtf8();
+    data+="; Comment line\n";
+    for(int j=0;j<8;j++) {
+      data+=QString::asprintf("  Tag%d = Value %d=%d  \n",j,i,j).toUtf8();
+    }
+    data+="\n";
+  }
+  QTemporaryFile file;
+  if((!file.open())||(file.write(data)!=data.size())||(!file.flush())) {
+    fprintf(stderr,"run_tests: unable to write temporary file\n");
+    exit(1);
+  }
+  QStringList lines=QString::fromUtf8(data).split("\n",Qt::KeepEmptyParts);
+  for(int i=0;i<lines.size();i++) {
+    lines[i]=lines.at(i).trimmed();
+  }
+
+  for(int i=0;i<2;i++) {
+    Profile *file_p=new Profile(i==1);
+    Profile *list_p=new Profile(i==1);
+    file_p->loadFile(file.fileName());
+    list_p->addSource(lines);
+    PrintSingleResult(QString("Chunked Load Dump Test")+
+		      ((i==1)?" [Section IDs]":""),
+		      file_p->dump()==list_p->dump(),&pass,&fail);
+    Profile *lazy_p=new Profile(i==1);
+    lazy_p->setLazyLoad(true);
+    lazy_p->loadFile(file.fileName());
+    bool lazy_ok=(lazy_p->sections()==list_p->sections())&&
+      (lazy_p->sectionIds("Section3")==list_p->sectionIds("Section3"));
+    PrintSingleResult(QString("Lazy Load Dump Test")+
+		      ((i==1)?" [Section IDs]":""),
+		      lazy_ok&&(lazy_p->dump()==list_p->dump()),&pass,&fail);
+    delete lazy_p;
+    delete list_p;
+    delete file_p;
+  }
+
+  *pass_ctr+=pass;
+  *fail_ctr+=fail;
+
+  return fail==0;
+}
+
+
+bool MainObject::RunAsyncLoadTests(int *pass_ctr,int *fail_ctr)
+{
+  int pass=0;
+  int fail=0;
+  bool result_ok=false;
+
+  QByteArray data;
+  for(int i=0;data.size()<(RUN_TESTS_ASYNC_LOAD_MBYTES*1048576);i++) {
+    data+=QString::asprintf("[Section%d]\n",i%64).toUtf8();
+    for(int j=0;j<16;j++) {
+      data+=QString::asprintf("Tag%d=Value %d of section %d\n",j,j,i).
+	toUtf8();
+    }
+    data+="\n";
+  }
+  QTemporaryFile file;
+  if((!file.open())||(file.write(data)!=data.size())||(!file.flush())) {
+    fprintf(stderr,"run_tests: unable to write temporary file\n");
+    exit(1);
+  }
+  data.clear();
+
+  //
+  // The event loop has to keep running timers while the load is going.
+  // The longest gap between ticks depends on the machine, so it is
+  // printed rather than checked.
+  //
+  ProfileLoader *loader=new ProfileLoader(this);
+  QEventLoop loop;
+  QTimer *timer=new QTimer(this);
+  QElapsedTimer clock;
+  int ticks=0;
+  int loading_ticks=0;
+  int result=-1;
+  qint64 last_tick=0;
+  qint64 max_gap=0;
+  QStringList err_msgs;
+  connect(timer,&QTimer::timeout,[&]() {
+      qint64 now=clock.elapsed();
+      max_gap=qMax(max_gap,now-last_tick);
+      last_tick=now;
+      ticks++;
+      if(loader->isLoading()) {
+	loading_ticks++;
+      }
+    });
+  connect(loader,&ProfileLoader::loaded,
+	  [&](int res,const QStringList &msgs) {
+	    result=res;
+	    err_msgs=msgs;
+	    loop.quit();
+	  });
+  clock.start();
+  timer->start(1);
+  Profile *rejected=new Profile();
+  result_ok=loader->load(new Profile(),file.fileName())&&
+    loader->isLoading()&&(!loader->load(rejected,file.fileName()));
+  delete rejected;
+  QTimer::singleShot(30000,&loop,SLOT(quit()));
+  loop.exec();
+  timer->stop();
+  qint64 elapsed=clock.elapsed();
+  printf("  Load took %lldms, %d timer ticks (%d while loading), "
+	 "longest gap %lldms\n",
+	 (long long)elapsed,ticks,loading_ticks,(long long)max_gap);
+  PrintSingleResult("Async Load Busy",result_ok,&pass,&fail);
+  PrintSingleResult("Async Load Timers Serviced",
+		    (result==1)&&(loading_ticks>0),&pass,&fail);
+
+  Profile *p=new Profile();
+  QStringList sync_msgs;
+  p->load(file.fileName(),&sync_msgs);
+  Profile *async=loader->takeProfile();
+  result_ok=(async!=NULL)&&(loader->profile()==NULL)&&
+    (err_msgs==sync_msgs)&&(async->dump()==p->dump());
+  PrintSingleResult("Async Load Result",result_ok,&pass,&fail);
+  delete async;
+  delete p;
+
+  //
+  // Errors are reported the same way load() reports them
+  //
+  result=0;
+  loader->load(new Profile(),"/no/such/dir/*.conf");
+  QTimer::singleShot(30000,&loop,SLOT(quit()));
+  loop.exec();
+  p=new Profile();
+  sync_msgs.clear();
+  int sync_result=p->load("/no/such/dir/*.conf",&sync_msgs);
+  PrintSingleResult("Async Load Errors",
+		    (result==sync_result)&&(err_msgs==sync_msgs),&pass,&fail);
+  delete p;
+  delete timer;
+  delete loader;
+
+  *pass_ctr+=pass;
+  *fail_ctr+=fail;
+
+  return fail==0;
+}
+
+
+bool MainObject::RunScalingTests(int *pass_ctr,int *fail_ctr)
+{
+  int pass=0;
+  int fail=0;
+
+  //
+  // Quadrupling the repeats should roughly quadruple the load time; a
+  // quadratic pipeline would take sixteen times as long. The bound is set
+  // at ten times, well clear of both, and each time is the best of several
+  // runs so that a single slow one on a loaded machine can't fail it.
+  //
+  for(int i=0;i<2;i++) {
+    qint64 small=ScalingLoadTime(RUN_TESTS_SCALING_REPEATS,i==1);
+    qint64 large=ScalingLoadTime(4*RUN_TESTS_SCALING_REPEATS,i==1);
+    printf("  %s: %d repeats in %lldus, %d repeats in %lldus\n",
+	   (i==1)?"loadFile()":"addSource()",
+	   RUN_TESTS_SCALING_REPEATS,(long long)small/1000,
+	   4*RUN_TESTS_SCALING_REPEATS,(long long)large/1000);
+    PrintSingleResult(QString((i==1)?"loadFile()":"addSource()")+
+		      " Linear Scaling Test",
+		      (small>0)&&(large>0)&&(large<(10*small)),
+		      &pass,&fail);
+  }
+
+  *pass_ctr+=pass;
+  *fail_ctr+=fail;
+
+  return fail==0;
+}
+
+
+qint64 MainObject::ScalingLoadTime(int repeats,bool from_file) const
+{
+  //
+  // One tag repeated in a single section, plus one section split across
+  // many blocks
+  //
+  QStringList lines;
+  lines.push_back("[Repeated]");
+  for(int i=0;i<repeats;i++) {
+    lines.push_back(QString::asprintf("Value=%d",i));
+  }
+  for(int i=0;i<repeats;i++) {
+    lines.push_back("[Split]");
+    lines.push_back(QString::asprintf("Value=%d",i));
+  }
+  QTemporaryFile file;
+  if(from_file) {
+    QByteArray data=lines.join("\n").toUtf8();
+    if((!file.open())||(file.write(data)!=data.size())||(!file.flush())) {
+      fprintf(stderr,"run_tests: unable to write temporary file\n");
+      exit(1);
+    }
+  }
+
+  //
+  // Best of several, to keep scheduling noise out of the ratio
+  //
+  qint64 ret=-1;
+  for(int i=0;i<RUN_TESTS_SCALING_RUNS;i++) {
+    Profile *p=new Profile();
+    QElapsedTimer timer;
+    timer.start();
+    if(from_file) {
+      p->loadFile(file.fileName());
+    }
+    else {
+      p->addSource(lines);
+    }
+    qint64 elapsed=timer.nsecsElapsed();
+    if((p->valueCount("Repeated","Value")!=repeats)||
+       (p->valueCount("Split","Value")!=repeats)) {
+      delete p;
+      return -1;
+    }
+    if((ret<0)||(elapsed<ret)) {
+      ret=elapsed;
+    }
+    delete p;
+  }
+
+  return ret;
+}
+
+
+bool MainObject::RunCompiledTests(int *pass_ctr,int *fail_ctr)
+{
+  int pass=0;
+  int fail=0;
+  QString err_msg;
+
+  QTemporaryFile compiled;
+  if(!compiled.open()) {
+    fprintf(stderr,"run_tests: unable to create temporary file\n");
+    exit(1);
+  }
+  compiled.close();
+
+  //
+  // Round trip
+  //
+  Profile *p=new Profile(true);
+  p->load("../../fixtures/extended_part*.conf",NULL);
+  bool saved=p->saveCompiled(compiled.fileName(),&err_msg);
+  Profile *c=new Profile(true);
+  bool loaded=c->loadCompiled(compiled.fileName(),&err_msg);
+  PrintSingleResult("Compiled Round Trip Test",
+		    saved&&loaded&&(c->dump()==p->dump()),&pass,&fail);
+  delete c;
+  c=new Profile(false);
+  PrintSingleResult("Compiled Section ID Mode Test",
+		    !c->loadCompiled(compiled.fileName()),&pass,&fail);
+  delete c;
+  delete p;
+
+  //
+  // Corruption
+  //
+  QFile file(compiled.fileName());
+  QByteArray bytes;
+  if(file.open(QIODevice::ReadOnly)) {
+    bytes=file.readAll();
+    file.close();
+  }
+  if(bytes.size()>0) {
+    bytes[bytes.size()-1]=bytes.at(bytes.size()-1)^0x01;
+  }
+  if((!file.open(QIODevice::WriteOnly|QIODevice::Truncate))||
+     (file.write(bytes)!=bytes.size())) {
+    fprintf(stderr,"run_tests: unable to write temporary file\n");
+    exit(1);
+  }
+  file.close();
+  c=new Profile(true);
+  PrintSingleResult("Compiled Corruption Test",
+		    !c->loadCompiled(compiled.fileName()),&pass,&fail);
+  delete c;
+
+  //
+  // Stale sources
+  //
+  QTemporaryFile source;
+  if((!source.open())||(source.write("[Tests]\nValue=1\n")<0)||
+     (!source.flush())) {
+    fprintf(stderr,"run_tests: unable to write temporary file\n");
+    exit(1);
+  }
+  p=new Profile();
+  p->loadFile(source.fileName());
+  p->saveCompiled(compiled.fileName());
+  c=new Profile();
+  loaded=c->loadCompiled(compiled.fileName());
+  source.write("Value=2\n");
+  source.flush();
+  PrintSingleResult("Compiled Stale Source Test",
+		    loaded&&(!c->loadCompiled(compiled.fileName())),
+		    &pass,&fail);
+  delete c;
+  delete p;
+
+  *pass_ctr+=pass;
+  *fail_ctr+=fail;
+
+  return fail==0;
+}
+
+
+bool MainObject::RunStatsTests(int *pass_ctr,int *fail_ctr)
+{
+  int pass=0;
+  int fail=0;
+  bool result_ok=false;
+
+  Profile *p=new Profile();
+  p->loadFile("../../fixtures/legacy.conf");
+  p->intValue("Tests","IntegerValue");
+  PrintSingleResult("Stats Disabled",
+		    (!p->statsEnabled())&&(!p->stats().isEnabled())&&
+		    (p->stats().totalCalls()==0),&pass,&fail);
+  delete p;
+
+  //
+  // Load and contents
+  //
+  p=new Profile();
+  p->setStatsEnabled(true);
+  p->loadFile("../../fixtures/legacy.conf");
+  ProfileStats stats=p->stats();
+  QList<ProfileStats::File> files=stats.files();
+  result_ok=stats.isEnabled()&&(files.size()==1)&&
+    (files.at(0).path=="../../fixtures/legacy.conf")&&
+    (files.at(0).bytes==QFileInfo("../../fixtures/legacy.conf").size())&&
+    (files.at(0).nsecs>0);
+  PrintSingleResult("Stats File Load",result_ok,&pass,&fail);
+  QStringList sections=p->sections();
+  result_ok=(stats.sectionCount()==sections.size())&&
+    (stats.tagCount()>0)&&(stats.valueCount()>=stats.tagCount())&&
+    (stats.pendingSectionCount()==0)&&(stats.heapBytes()>0);
+  PrintSingleResult("Stats Contents",result_ok,&pass,&fail);
+  int tags=stats.tagCount();
+  int values=stats.valueCount();
+
+  //
+  // Lookups
+  //
+  Profile::Key key("Tests","StringValue");
+  p->intValue("Tests","IntegerValue");
+  p->intValues("Tests","IntegerValue");
+  p->intValue("Tests","NoSuchInteger",7);
+  p->stringValue(key);
+  p->boolValue("Tests","NoSuchBool");
+  p->valueCount("Tests","IntegerValue");
+  stats=p->stats();
+  result_ok=(stats.hits(ProfileStats::Int)==2)&&
+    (stats.misses(ProfileStats::Int)==1)&&
+    (stats.hits(ProfileStats::String)==1)&&
+    (stats.misses(ProfileStats::Bool)==1)&&
+    (stats.calls(ProfileStats::Count)==1)&&
+    (stats.totalCalls()==6)&&(stats.totalMisses()==2);
+  PrintSingleResult("Stats Lookup Counts",result_ok,&pass,&fail);
+  p->resetStats();
+  stats=p->stats();
+  result_ok=(stats.totalCalls()==0)&&stats.files().isEmpty()&&
+    (stats.tagCount()==tags)&&(stats.valueCount()==values);
+  PrintSingleResult("Stats Reset",result_ok,&pass,&fail);
+  delete p;
+
+  //
+  // Lazy sections are counted without being parsed
+  //
+  p=new Profile(true);
+  p->setLazyLoad(true);
+  p->setStatsEnabled(true);
+  p->loadFile("../../fixtures/extended.conf");
+  stats=p->stats();
+  result_ok=(stats.pendingSectionCount()>0)&&
+    (stats.pendingSectionCount()==stats.sectionCount())&&
+    (stats.valueCount()==0);
+  p->dump();
+  stats=p->stats();
+  result_ok=result_ok&&(stats.pendingSectionCount()==0)&&
+    (stats.valueCount()>0);
+  PrintSingleResult("Stats Lazy Sections",result_ok,&pass,&fail);
+  delete p;
+
+  *pass_ctr+=pass;
+  *fail_ctr+=fail;
+
+  return fail==0;
+}
+
+
+bool MainObject::RunFileCacheTests(int *pass_ctr,int *fail_ctr)
+{
+  int pass=0;
+  int fail=0;
+  bool result_ok=false;
+  Profile *p[3];
+
+  //
+  // Disabled by default
+  //
+  for(int i=0;i<2;i++) {
+    p[i]=new Profile();
+    p[i]->setStatsEnabled(true);
+    p[i]->loadFile("../../fixtures/legacy.conf");
+  }
+  result_ok=(Profile::fileCacheLimit()==0)&&
+    (!p[1]->stats().files().at(0).cached);
+  PrintSingleResult("File Cache Disabled",result_ok,&pass,&fail);
+  delete p[0];
+  delete p[1];
+
+  //
+  // Shared parse
+  //
+  Profile::setFileCacheLimit(1048576);
+  for(int i=0;i<2;i++) {
+    p[i]=new Profile();
+    p[i]->setStatsEnabled(true);
+    p[i]->loadFile("../../fixtures/legacy.conf");
+  }
+  result_ok=(!p[0]->stats().files().at(0).cached)&&
+    p[1]->stats().files().at(0).cached&&(p[0]->dump()==p[1]->dump());
+  PrintSingleResult("File Cache Hit",result_ok,&pass,&fail);
+  delete p[0];
+  delete p[1];
+
+  //
+  // Invalidation
+  //
+  QTemporaryDir dir;
+  QString filename=dir.path()+"/cache.conf";
+  WriteFile(filename,"[Tests]\nValue=1\n");
+  for(int i=0;i<3;i++) {
+    p[i]=new Profile();
+    p[i]->setStatsEnabled(true);
+    if(i==2) {
+      WriteFile(filename,"[Tests]\nValue=22\n");
+    }
+    p[i]->loadFile(filename);
+  }
+  result_ok=p[1]->stats().files().at(0).cached&&
+    (p[1]->intValue("Tests","Value")==1)&&
+    (!p[2]->stats().files().at(0).cached)&&
+    (p[2]->intValue("Tests","Value")==22)&&
+    (p[0]->intValue("Tests","Value")==1);
+  PrintSingleResult("File Cache Invalidation",result_ok,&pass,&fail);
+  for(int i=0;i<3;i++) {
+    delete p[i];
+  }
+
+  //
+  // Size limit
+  //
+  Profile::setFileCacheLimit(8);
+  for(int i=0;i<2;i++) {
+    p[i]=new Profile();
+    p[i]->setStatsEnabled(true);
+    p[i]->loadFile(filename);
+  }
+  result_ok=!p[1]->stats().files().at(0).cached;
+  PrintSingleResult("File Cache Size Limit",result_ok,&pass,&fail);
+  delete p[0];
+  delete p[1];
+  Profile::setFileCacheLimit(0);
+
+  *pass_ctr+=pass;
+  *fail_ctr+=fail;
+
+  return fail==0;
+}
+
+
+bool MainObject::RunLayerTests(int *pass_ctr,int *fail_ctr)
+{
+  int pass=0;
+  int fail=0;
+  bool result_ok=false;
+
+  QSharedPointer<Profile> base(new Profile());
+  base->loadData(QByteArray("[Tests]\nA=1\nB=2\nB=3\n[Base]\nD=4\n"));
+  QSharedPointer<Profile> tenant[2];
+  for(int i=0;i<2;i++) {
+    tenant[i]=QSharedPointer<Profile>(new Profile());
+    tenant[i]->setBaseLayer(base);
+  }
+  tenant[0]->loadData(QByteArray("[Tests]\nB=9\n[Extra]\nC=x\n"));
+  tenant[1]->loadData(QByteArray("[Tests]\nA=5\n"));
+
+  //
+  // Fall-through and override
+  //
+  result_ok=(tenant[0]->layerCount()==2)&&
+    (tenant[0]->intValue("Tests","A")==1)&&
+    (tenant[0]->intValues("Tests","B")==(QList<int>()<<9))&&
+    (tenant[0]->stringValue("Extra","C")=="x")&&
+    (tenant[0]->intValue("Base","D")==4)&&
+    tenant[0]->stringValues("Tests","E").isEmpty();
+  PrintSingleResult("Layer Fall-Through",result_ok,&pass,&fail);
+  result_ok=(tenant[0]->baseLayer()==tenant[1]->baseLayer())&&
+    (tenant[1]->intValue("Tests","A")==5)&&
+    (tenant[1]->intValues("Tests","B")==(QList<int>()<<2<<3))&&
+    (base->intValue("Tests","A")==1)&&
+    (base->stringValue("Extra","C","none")=="none");
+  PrintSingleResult("Layer Shared Base",result_ok,&pass,&fail);
+
+  //
+  // Whole-profile views match the equivalent single profile
+  //
+  Profile *flat=new Profile();
+  flat->loadData(QByteArray("[Base]\nD=4\n[Extra]\nC=x\n"
+			    "[Tests]\nA=1\nB=9\n"));
+  result_ok=(tenant[0]->dump()==flat->dump())&&
+    (tenant[0]->sections()==flat->sections())&&
+    (tenant[0]->sectionNames()==flat->sectionNames());
+  PrintSingleResult("Layer Dump",result_ok,&pass,&fail);
+  delete flat;
+
+  //
+  // Keys and bindings
+  //
+  Profile::Key key("Tests","A");
+  result_ok=tenant[0]->intValue(key)==1;
+  QSharedPointer<Profile> other(new Profile());
+  other->loadData(QByteArray("[Tests]\nA=7\n"));
+  tenant[0]->setBaseLayer(other);
+  result_ok=result_ok&&(tenant[0]->intValue(key)==7);
+  tenant[0]->setBaseLayer(base);
+  result_ok=result_ok&&(tenant[0]->intValue(key)==1);
+  PrintSingleResult("Layer Keys",result_ok,&pass,&fail);
+  static const ProfileBinding<BindingTest> binding=
+    ProfileBinding<BindingTest>().
+    bind("Tests","A",&BindingTest::int_value).
+    bind("Tests","B",&BindingTest::int_values);
+  BindingTest bound;
+  result_ok=binding.read(tenant[0].data(),&bound)&&(bound.int_value==1)&&
+    (bound.int_values==(QList<int>()<<9));
+  PrintSingleResult("Layer Binding",result_ok,&pass,&fail);
+
+  //
+  // Invalid stacks
+  //
+  Profile *ids=new Profile(true);
+  result_ok=(!base->setBaseLayer(tenant[0]))&&(!ids->setBaseLayer(base))&&
+    (base->layerCount()==1)&&(ids->layerCount()==1);
+  PrintSingleResult("Layer Rejected",result_ok,&pass,&fail);
+  delete ids;
+
+  //
+  // Per-layer statistics
+  //
+  tenant[0]->setStatsEnabled(true);
+  tenant[0]->intValue("Tests","A");
+  tenant[0]->intValue("Tests","B");
+  tenant[0]->stringValue("Extra","C");
+  tenant[0]->intValue("Tests","E");
+  ProfileStats stats=tenant[0]->stats();
+  result_ok=(stats.layerCount()==2)&&(stats.layerHits(0)==2)&&
+    (stats.layerHits(1)==1)&&(stats.totalMisses()==1)&&
+    (stats.sectionCount()==2)&&(stats.tagCount()==2);
+  PrintSingleResult("Layer Stats",result_ok,&pass,&fail);
+  tenant[0]->resetStats();
+  binding.read(tenant[0].data(),&bound);
+  stats=tenant[0]->stats();
+  result_ok=(stats.layerHits(0)==1)&&(stats.layerHits(1)==1)&&
+    (stats.hits(ProfileStats::Int)==2)&&(stats.totalMisses()==0);
+  PrintSingleResult("Layer Binding Stats",result_ok,&pass,&fail);
+
+  *pass_ctr+=pass;
+  *fail_ctr+=fail;
+
+  return fail==0;
+}
+
+
+bool MainObject::RunWatcherTests(int *pass_ctr,int *fail_ctr)
+{
+  int pass=0;
+  int fail=0;
+
+  QTemporaryDir dir;
+  if(!dir.isValid()) {
+    fprintf(stderr,"run_tests: unable to create temporary directory\n");
+    exit(1);
+  }
+  WriteFile(dir.filePath("a.conf"),"[Alpha]\nValue=1\n[Shared]\nValue=a\n");
+  WriteFile(dir.filePath("b.conf"),"[Beta]\nValue=2\n[Shared]\nValue=b\n");
+
+  ProfileWatcher *w=new ProfileWatcher(false,this);
+  w->setDebounceInterval(50);
+  int num=w->watchDirectory(dir.path(),"*.conf");
+  PrintSingleResult("Watch Directory Load",num==2,&pass,&fail);
+
+  QStringList changed;
+  QEventLoop loop;
+  connect(w,&ProfileWatcher::changed,[&](const QStringList &sections) {
+      changed=sections;
+      loop.quit();
+    });
+
+  //
+  // Edit one file
+  //
+  WriteFile(dir.filePath("b.conf"),"[Beta]\nValue=3\n[Shared]\nValue=c\n");
+  QTimer::singleShot(5000,&loop,SLOT(quit()));
+  loop.exec();
+  Profile *p=new Profile();
+  p->loadDirectory(dir.path(),"*.conf",NULL);
+  PrintSingleResult("Watch Modified File",
+		    (w->profile()->dump()==p->dump())&&
+		    (w->profile()->sections()==p->sections())&&
+		    (changed==(QStringList()<<"Beta"<<"Shared")),&pass,&fail);
+  delete p;
+
+  //
+  // Add one file, remove another
+  //
+  changed.clear();
+  WriteFile(dir.filePath("c.conf"),"[Gamma]\nValue=4\n");
+  QFile::remove(dir.filePath("a.conf"));
+  QTimer::singleShot(5000,&loop,SLOT(quit()));
+  loop.exec();
+  p=new Profile();
+  p->loadDirectory(dir.path(),"*.conf",NULL);
+  PrintSingleResult("Watch Added And Removed Files",
+		    (w->profile()->dump()==p->dump())&&
+		    (w->profile()->sections()==p->sections())&&
+		    (changed==(QStringList()<<"Alpha"<<"Gamma"<<"Shared")),
+		    &pass,&fail);
+  delete p;
+
+  //
+  // Move the directory away, then back
+  //
+  changed.clear();
+  QDir().rename(dir.path(),dir.path()+".moved");
+  QTimer::singleShot(5000,&loop,SLOT(quit()));
+  loop.exec();
+  bool emptied=w->profile()->sections().isEmpty()&&
+    (changed==(QStringList()<<"Beta"<<"Gamma"<<"Shared"));
+  changed.clear();
+  QDir().rename(dir.path()+".moved",dir.path());
+  QTimer::singleShot(5000,&loop,SLOT(quit()));
+  loop.exec();
+  p=new Profile();
+  p->loadDirectory(dir.path(),"*.conf",NULL);
+  PrintSingleResult("Watch Moved Directory",
+		    emptied&&(w->profile()->dump()==p->dump())&&
+		    (changed==(QStringList()<<"Beta"<<"Gamma"<<"Shared")),
+		    &pass,&fail);
+  delete p;
+  delete w;
+
+  *pass_ctr+=pass;
+  *fail_ctr+=fail;
+
+  return fail==0;
+}
+
+
+bool MainObject::RunSharedProfileTests(int *pass_ctr,int *fail_ctr)
+{
+  int pass=0;
+  int fail=0;
+  int errors=0;
+
+  SharedProfile *shared=new SharedProfile();
+  shared->load("../../fixtures/legacy.conf",NULL);
+  QVector<qint64> idle=SharedReadLatencies(shared,false,&errors);
+  QVector<qint64> busy=SharedReadLatencies(shared,true,&errors);
+  delete shared;
+
+  printf("  Read latency, idle: p50=%lldns p99=%lldns\n",
+	 (long long)Percentile(idle,50),(long long)Percentile(idle,99));
+  printf("  Read latency, reloading: p50=%lldns p99=%lldns\n",
+	 (long long)Percentile(busy,50),(long long)Percentile(busy,99));
+  PrintSingleResult("Shared Profile Reads During Reload",
+		    (errors==0)&&(busy.size()>0),&pass,&fail);
+  PrintSingleResult("Shared Profile Read Latency",
+		    Percentile(busy,50)<=(10*Percentile(idle,50)+10000),
+		    &pass,&fail);
+
+  //
+  // A reload that fails leaves the current snapshot in place
+  //
+  QTemporaryDir dir;
+  QString filename=dir.path()+"/shared.conf";
+  QStringList err_msgs;
+  WriteFile(filename,"[Tests]\nValue=1\n");
+  shared=new SharedProfile();
+  bool result_ok=shared->load(filename,NULL)==1;
+  QFile::remove(filename);
+  result_ok=result_ok&&(shared->load(filename,&err_msgs)<0)&&
+    (!err_msgs.isEmpty())&&(shared->load(dir.path()+"/*.conf",NULL)<0)&&
+    (shared->load(dir.path()+"/missing/*.conf",NULL)<0);
+  {
+    SharedProfile::ReadLock lock(shared);
+    result_ok=result_ok&&(lock->intValue("Tests","Value")==1);
+  }
+  PrintSingleResult("Shared Profile Failed Reload",result_ok,&pass,&fail);
+  delete shared;
+
+  *pass_ctr+=pass;
+  *fail_ctr+=fail;
+
+  return fail==0;
+}
+
+
+QVector<qint64> MainObject::SharedReadLatencies(SharedProfile *shared,
+						bool reload,int *errors) const
+{
+  int readers=qMax(2,QThread::idealThreadCount()-1);
+  QAtomicInt stop(0);
+  QAtomicInt bad(0);
+  QVector<QVector<qint64> > latencies(readers);
+  QVector<qint64> *results=latencies.data();
+  QList<QThread *> threads;
+
+  for(int i=0;i<readers;i++) {
+    threads.push_back(QThread::create([shared,&stop,&bad,results,i]() {
+	  QVector<qint64> *samples=results+i;
+	  QElapsedTimer timer;
+	  samples->reserve(RUN_TESTS_LATENCY_SAMPLES);
+	  while(stop.loadAcquire()==0) {
+	    timer.start();
+	    {
+	      SharedProfile::ReadLock lock(shared);
+	      if(lock->intValue("Tests","IntegerValue")!=1234) {
+		bad.ref();
+	      }
+	    }
+	    qint64 nsecs=timer.nsecsElapsed();
+	    if(samples->size()<RUN_TESTS_LATENCY_SAMPLES) {
+	      samples->push_back(nsecs);
+	    }
+	  }
+	}));
+    threads.last()->start();
+  }
+
+  QElapsedTimer clock;
+  clock.start();
+  while(clock.elapsed()<300) {
+    if(reload) {
+      shared->load("../../fixtures/legacy.conf",NULL);
+    }
+    else {
+      QThread::msleep(10);
+    }
+  }
+  stop.storeRelease(1);
+  for(int i=0;i<threads.size();i++) {
+    threads.at(i)->wait();
+    delete threads.at(i);
+  }
+
+  QVector<qint64> ret;
+  for(int i=0;i<latencies.size();i++) {
+    ret+=latencies.at(i);
+  }
+  std::sort(ret.begin(),ret.end());
+  *errors+=bad.loadAcquire();
+
+  return ret;
+}
+
+
+qint64 MainObject::Percentile(const QVector<qint64> &sorted,int pct) const
+{
+  if(sorted.size()==0) {
+    return 0;
+  }
+  return sorted.at(qMin(sorted.size()-1,sorted.size()*pct/100));
+}
+
+
+void MainObject::WriteFile(const QString &filename,const QString &data) const
+{
+  QFile file(filename);
+  QByteArray bytes=data.toUtf8();
+
+  if((!file.open(QIODevice::WriteOnly|QIODevice::Truncate))||
+     (file.write(bytes)!=bytes.size())) {
+    fprintf(stderr,"run_tests: unable to write \"%s\"\n",
+	    filename.toUtf8().constData());
+    exit(1);
+  }
+}
+
+
 bool MainObject::DumpTest(const QString &fixture,const QString &exemplar,
 			  bool use_sect_ids,const QString &name,
 			  int *pass_ctr,int *fail_ctr)
 {
-  QStringList args;
-  args.push_back(QString::asprintf("--path=../../fixtures/%s",
-				   fixture.toUtf8().constData()));
-  args.push_back(QString::asprintf("--compare-to=../../fixtures/%s",
-				   exemplar.toUtf8().constData()));
-  if(use_sect_ids) {
-    args.push_back("--use-section-ids");
+  QStringList err_msgs;
+  QString err_msg;
+  Profile *p=new Profile(use_sect_ids);
+  if(p->load("../../fixtures/"+fixture,&err_msgs)<0) {
+    fprintf(stderr,"run_tests: failed to load fixture \"%s\"\n",
+	    fixture.toUtf8().constData());
+    exit(1);
   }
-  QProcess *proc=new QProcess(this);
-  proc->start("./dump_profile",args);
-  proc->waitForFinished();
-  if(proc->exitStatus()!=QProcess::NormalExit) {
-    fprintf(stderr,"run_tests: dump_profile crashed\n");
+  Profile *e=new Profile(use_sect_ids);
+  if(!e->loadFile("../../fixtures/"+exemplar,&err_msg)) {
+    fprintf(stderr,"run_tests: failed to load exemplar \"%s\" [%s]\n",
+	    exemplar.toUtf8().constData(),err_msg.toUtf8().constData());
     exit(1);
   }
-  if(proc->exitCode()!=0) {
-    fprintf(stderr,"run_tests: dump_profile returned non-zero exit code [%s]\n",
-	    proc->readAllStandardError().constData());
+  ProfileDiff *diff=new ProfileDiff(e,p);
+  bool result=diff->isEmpty();
+  if(!result) {
+    fprintf(stderr,"%s",diff->unified(exemplar,fixture).toUtf8().constData());
+  }
+
+  //
+  // The exemplars are dumps themselves, so the text must match exactly
+  //
+  QFile file("../../fixtures/"+exemplar);
+  if(!file.open(QIODevice::ReadOnly)) {
+    fprintf(stderr,"run_tests: failed to read exemplar \"%s\"\n",
+	    exemplar.toUtf8().constData());
     exit(1);
   }
-  QString diff=proc->readAllStandardOutput();
-  bool result=diff.isEmpty();
+  if(p->dump().toUtf8()!=file.readAll()) {
+    fprintf(stderr,"run_tests: dump of \"%s\" does not match \"%s\"\n",
+	    fixture.toUtf8().constData(),exemplar.toUtf8().constData());
+    result=false;
+  }
   PrintSingleResult(name,result,pass_ctr,fail_ctr);
+  delete diff;
+  delete e;
+  delete p;
 
   return result;
 }
@@ -23,9 +23,30 @@
 
 #include <QObject>
 
+#include <QVector>
+
 #include <profile.h>
+#include <sharedprofile.h>
 
 #define RUN_TESTS_USAGE "\n\n"
+#define RUN_TESTS_LATENCY_SAMPLES 100000
+#define RUN_TESTS_SCALING_REPEATS 20000
+#define RUN_TESTS_SCALING_RUNS 5
+#define RUN_TESTS_ASYNC_LOAD_MBYTES 16
+
+struct BindingTest
+{
+  QString string_value;
+  int int_value;
+  QList<int> int_values;
+  int hex_value;
+  double double_value;
+  bool bool_value;
+  QTime time_value;
+  QHostAddress address_value;
+  int missing_value;
+};
+
 
 class MainObject : public QObject
 {
@@ -37,7 +58,22 @@ class MainObject : public QObject
   bool RunLegacyTests(Profile *p,int *pass_ctr,int *fail_ctr) const;
   bool RunExtendedTests(Profile *p,int *pass_ctr,int *fail_ctr) const;
   bool RunSendmailTests(int *pass_ctr,int *fail_ctr) const;
+  bool RunMemoryLoadTests(int *pass_ctr,int *fail_ctr);
   bool RunDumpTests(int *pass_ctr,int *fail_ctr);
+  bool RunLargeFileTests(int *pass_ctr,int *fail_ctr);
+  bool RunAsyncLoadTests(int *pass_ctr,int *fail_ctr);
+  bool RunScalingTests(int *pass_ctr,int *fail_ctr);
+  qint64 ScalingLoadTime(int repeats,bool from_file) const;
+  bool RunCompiledTests(int *pass_ctr,int *fail_ctr);
+  bool RunStatsTests(int *pass_ctr,int *fail_ctr);
+  bool RunFileCacheTests(int *pass_ctr,int *fail_ctr);
+  bool RunLayerTests(int *pass_ctr,int *fail_ctr);
+  bool RunWatcherTests(int *pass_ctr,int *fail_ctr);
+  bool RunSharedProfileTests(int *pass_ctr,int *fail_ctr);
+  QVector<qint64> SharedReadLatencies(SharedProfile *shared,bool reload,
+				      int *errors) const;
+  qint64 Percentile(const QVector<qint64> &sorted,int pct) const;
+  void WriteFile(const QString &filename,const QString &data) const;
   bool DumpTest(const QString &fixture,const QString &exemplar,
 		bool use_sect_ids,const QString &name,
 		int *pass_ctr,int *fail_ctr);